@@ -0,0 +1,76 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Memory bandwidth achieved by the stage combination loops of the direct RK4 and DOPRI45 integrators for large states,
+// per instruction set, compared against a STREAM style triad. The system does no work, so a step is only its stage loops.
+
+#include "ascent/Ascent.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace asc;
+
+template <class F>
+double seconds(F&& f, const size_t repetitions)
+{
+   f(); // warm up, touches every page
+   const auto start = std::chrono::steady_clock::now();
+   for (size_t r = 0; r < repetitions; ++r) {
+      f();
+   }
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+double gbs(const double doubles, const double s) { return doubles * sizeof(double) / s * 1.0e-9; }
+
+int main(int argc, char* argv[])
+{
+   const size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (size_t(1) << 22);
+   const size_t repetitions = 10;
+
+   state_t a(n, 1.0), b(n, 2.0), c(n, 3.0);
+   const double triad = seconds([&] {
+      for (size_t i = 0; i < n; ++i) {
+         a[i] = b[i] + 0.5 * c[i];
+      }
+   }, repetitions);
+   std::cout << "states: " << n << '\n';
+   std::cout << "triad: " << gbs(3.0 * n, triad) << " GB/s\n";
+
+   auto system = [](const state_t&, state_t&, const double) {};
+
+   const char* names[] = { "scalar", "sse2", "avx2", "avx512" };
+   for (auto isa : { simd::Isa::Scalar, simd::Isa::SSE2, simd::Isa::AVX2, simd::Isa::AVX512 })
+   {
+      if (simd::select(isa) != isa) {
+         continue;
+      }
+
+      state_t x(n, 1.0);
+      double t{};
+
+      RK4 rk4;
+      const double s_rk4 = seconds([&] { rk4(system, x, t, 0.01); }, repetitions);
+
+      DOPRI45 dopri45;
+      const double s_dopri45 = seconds([&] { dopri45(system, x, t, 0.01); }, repetitions);
+
+      // doubles read and written per step: the copy into x0 and every stage combination
+      std::cout << names[static_cast<int>(isa)] << ": RK4 " << gbs(19.0 * n, s_rk4) << " GB/s, DOPRI45 " << gbs(34.0 * n, s_dopri45) << " GB/s\n";
+   }
+
+   return 0;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace asc
+{
+   // The state type of a direct integrator, e.g. std::vector<double> for RK4T<std::vector<double>>
+   template <class integrator_t>
+   struct integrator_state;
+
+   template <template <class> class integrator_t, class state_t>
+   struct integrator_state<integrator_t<state_t>>
+   {
+      using type = state_t;
+   };
+
+   // View of ensemble members for the system, b[c] points to component c of every lane: b[c][l] is component c of the member in lane l.
+   // Lane l holds member(l), which differs from l when only part of an ensemble is evaluated.
+   template <class value_t>
+   struct Batch
+   {
+      value_t* data{};
+      size_t lanes{};
+      size_t states{};
+      const size_t* index{}; // member of each lane, nullptr if lane l is member l
+
+      size_t size() const noexcept { return lanes; }
+
+      value_t* operator[](const size_t c) const noexcept { return data + c * lanes; }
+
+      size_t member(const size_t l) const noexcept { return index ? index[l] : l; }
+   };
+
+   // N independent copies (members) of one system, integrated as a single state by a direct integrator.
+   // The state is lane interleaved: component c of member m is x[c * members + m], so the stage loops of the integrator sweep all members at once
+   // and the system is called once per stage with Batch views, letting its derivative loops vectorize across members.
+   // The system signature is (Batch<const value_t> x, Batch<value_t> xd, value_t t).
+   template <class integrator_t>
+   struct Ensemble
+   {
+      using state_t = typename integrator_state<integrator_t>::type;
+      using value_t = typename state_t::value_type;
+
+      Ensemble() = default;
+      Ensemble(const size_t n_states, const size_t n_members) : x(n_states * n_members), n_states(n_states), n_members(n_members) {}
+
+      size_t states() const noexcept { return n_states; }
+      size_t members() const noexcept { return n_members; }
+
+      value_t& operator()(const size_t c, const size_t m) noexcept { return x[c * n_members + m]; }
+      const value_t& operator()(const size_t c, const size_t m) const noexcept { return x[c * n_members + m]; }
+
+      Batch<value_t> batch() noexcept { return{ x.data(), n_members, n_states }; }
+      Batch<const value_t> batch() const noexcept { return{ x.data(), n_members, n_states }; }
+
+      // Gathers the state of member m
+      state_t member(const size_t m) const
+      {
+         state_t s(n_states);
+         for (size_t c = 0; c < n_states; ++c) {
+            s[c] = (*this)(c, m);
+         }
+         return s;
+      }
+
+      // Scatters a state into member m
+      void member(const size_t m, const state_t& s)
+      {
+         for (size_t c = 0; c < n_states; ++c) {
+            (*this)(c, m) = s[c];
+         }
+      }
+
+      // Steps every member, the trailing arguments are those of the integrator (dt, adaptive settings...)
+      template <class System, class... Args>
+      void operator()(System&& system, value_t& t, Args&&... args)
+      {
+         integrator([&](const state_t& xs, state_t& xd, const value_t ts) {
+            system(Batch<const value_t>{ xs.data(), n_members, n_states }, Batch<value_t>{ xd.data(), n_members, n_states }, ts);
+         }, x, t, std::forward<Args>(args)...);
+      }
+
+      integrator_t integrator;
+      state_t x;
+
+   private:
+      size_t n_states{};
+      size_t n_members{};
+   };
+}
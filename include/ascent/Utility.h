@@ -1,45 +1,158 @@
-// Copyright (c) 2016-2017 Anyar, Inc.
-// 
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-// 
-//      http://www.apache.org/licenses/LICENSE-2.0
-// 
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#pragma once
-
-#include <vector>
-
-namespace asc
-{
-   // User type definitions for ease of use
-   using value_t = double; // float, double, etc.
-   using state_t = std::vector<value_t>; // std::vector, std::deque, etc.
-
-   constexpr value_t cx(long double v) { return static_cast<value_t>(v); }
-   constexpr value_t operator"" _v(long double v) { return static_cast<value_t>(v); }
-
-   struct AdaptiveIntegrator
-   {
-      AdaptiveIntegrator() = default;
-      AdaptiveIntegrator(const AdaptiveIntegrator&) = default;
-      AdaptiveIntegrator(AdaptiveIntegrator&&) = default;
-      AdaptiveIntegrator& operator=(const AdaptiveIntegrator&) = default;
-      AdaptiveIntegrator& operator=(AdaptiveIntegrator&&) = default;
-      virtual ~AdaptiveIntegrator() = default;
-   };
-
-   template <typename T>
-   struct AdaptiveT
-   {
-      T abs_tol = static_cast<T>(1.0); // absolute tolerance
-      T rel_tol = static_cast<T>(1.0); // relative tolerance
-      T safety_factor = static_cast<T>(0.9); // value < 1.0 reduces time step change aggressiveness
-   };
+// Copyright (c) 2016-2017 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asc
+{
+   // User type definitions for ease of use
+   using value_t = double; // float, double, etc.
+   using state_t = std::vector<value_t>; // std::vector, std::deque, etc.
+
+   constexpr value_t cx(long double v) { return static_cast<value_t>(v); }
+   constexpr value_t operator"" _v(long double v) { return static_cast<value_t>(v); }
+
+   template <typename T>
+   struct is_pair : std::false_type { };
+
+   template <typename T, typename U>
+   struct is_pair<std::pair<T, U>> : std::true_type { };
+
+   template <typename T>
+   constexpr bool is_pair_v = is_pair<T>::value;
+
+   // A system is thread safe if its operator()(x, xd, t) may run concurrently on distinct x and xd, e.g. to estimate Jacobian columns in parallel.
+   // A system declares it through a member static constexpr bool thread_safe = true or a specialization of is_thread_safe.
+   template <class System>
+   struct is_thread_safe : std::bool_constant<requires { requires System::thread_safe; }> { };
+
+   template <class System>
+   constexpr bool is_thread_safe_v = is_thread_safe<std::remove_cvref_t<System>>::value;
+
+   // Declares a callable such as a lambda thread safe
+   template <class F>
+   struct ThreadSafe
+   {
+      static constexpr bool thread_safe = true;
+      F f;
+
+      template <class... Args>
+      decltype(auto) operator()(Args&&... args) { return f(std::forward<Args>(args)...); }
+   };
+
+   template <class F>
+   inline ThreadSafe<std::decay_t<F>> thread_safe(F&& f) { return { std::forward<F>(f) }; }
+
+   // Module containers hold pointers or (key, pointer) pairs, this returns the pointed to module in either case
+   template <class block_t>
+   inline auto& deref(block_t& block)
+   {
+      if constexpr (is_pair_v<std::remove_const_t<block_t>>) {
+         return *block.second;
+      }
+      else {
+         return *block;
+      }
+   }
+
+   // Fixed size states such as std::array<double, N> carry their size in the type,
+   // so integrator scratch lives inline, stage loops have compile time bounds and integrators are trivially copyable
+   template <class state_t>
+   concept fixed_size_state = requires { std::tuple_size<state_t>::value; };
+
+   // Resizes integrator scratch, a no-op for fixed size states
+   template <class state_t>
+   inline void resize(state_t& s, const size_t n)
+   {
+      if constexpr (!fixed_size_state<state_t>) {
+         s.resize(n);
+      }
+   }
+
+   // Calls f(i) for every element index of a state, unrolled at compile time for small fixed size states
+   template <class state_t, class F>
+   inline void for_each_index(const state_t& s, F&& f)
+   {
+      if constexpr (fixed_size_state<state_t> && requires { requires std::tuple_size<state_t>::value <= 16; })
+      {
+         [&]<size_t... I>(std::index_sequence<I...>) {
+            (f(I), ...);
+         }(std::make_index_sequence<std::tuple_size_v<state_t>>{});
+      }
+      else
+      {
+         const size_t n = s.size();
+         for (size_t i = 0; i < n; ++i) {
+            f(i);
+         }
+      }
+   }
+
+   struct AdaptiveIntegrator
+   {
+      AdaptiveIntegrator() = default;
+      AdaptiveIntegrator(const AdaptiveIntegrator&) = default;
+      AdaptiveIntegrator(AdaptiveIntegrator&&) = default;
+      AdaptiveIntegrator& operator=(const AdaptiveIntegrator&) = default;
+      AdaptiveIntegrator& operator=(AdaptiveIntegrator&&) = default;
+      virtual ~AdaptiveIntegrator() = default;
+   };
+
+   // Norm of the scaled error estimate of an adaptive step, the step is accepted if it is at most one
+   enum struct Norm
+   {
+      Max, // largest component
+      RMS // root mean square over all components
+   };
+
+   template <typename T>
+   struct AdaptiveT
+   {
+      T abs_tol = static_cast<T>(1.0); // absolute tolerance
+      T rel_tol = static_cast<T>(1.0); // relative tolerance
+      T safety_factor = static_cast<T>(0.9); // value < 1.0 reduces time step change aggressiveness
+      Norm norm = Norm::Max;
+
+      // Per component tolerances of a direct state, components beyond the size of either vector use abs_tol or rel_tol.
+      // Modular states carry their own tolerances, see Module::tolerance.
+      std::vector<T> abs_tols;
+      std::vector<T> rel_tols;
+
+      // Sizes the per component tolerances for n components, filled with the scalar tolerances
+      void components(const size_t n)
+      {
+         abs_tols.assign(n, abs_tol);
+         rel_tols.assign(n, rel_tol);
+      }
+
+      // Sets the tolerances of component i, sizing the per component tolerances for at least i + 1 components
+      void tolerance(const size_t i, const T abs, const T rel)
+      {
+         if (abs_tols.size() <= i) abs_tols.resize(i + 1, abs_tol);
+         if (rel_tols.size() <= i) rel_tols.resize(i + 1, rel_tol);
+         abs_tols[i] = abs;
+         rel_tols[i] = rel;
+      }
+
+      // Excludes component i from error control, its error counts as zero
+      void exclude(const size_t i) { tolerance(i, std::numeric_limits<T>::infinity(), T{}); }
+   };
 }
\ No newline at end of file
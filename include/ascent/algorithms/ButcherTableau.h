@@ -0,0 +1,224 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// Butcher tableaus of explicit Runge Kutta methods, for the ExplicitRK integrators.
+// A tableau is a type with constexpr stages, a (stage weights, strictly lower triangular), b (solution weights) and c (stage times).
+// Low storage schemes for the LowStorageRK integrators are given in Williamson 2N form instead:
+// dx = A[i] * dx + dt * f(x, t0 + C[i] * dt), x += B[i] * dx, with optional error weights E (the solution minus an embedded solution).
+// Schemes for the implicit SDIRK and Rosenbrock integrators add their diagonal gamma and embedded weights bhat.
+
+namespace asc
+{
+   namespace tableau
+   {
+      // Forward Euler
+      struct Euler
+      {
+         static constexpr size_t stages = 1;
+         static constexpr double a[stages][stages] = { { 0.0 } };
+         static constexpr double b[stages] = { 1.0 };
+         static constexpr double c[stages] = { 0.0 };
+      };
+
+      // Explicit midpoint
+      struct Midpoint
+      {
+         static constexpr size_t stages = 2;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0 },
+            { 0.5, 0.0 } };
+         static constexpr double b[stages] = { 0.0, 1.0 };
+         static constexpr double c[stages] = { 0.0, 0.5 };
+      };
+
+      // Heun's second order method
+      struct Heun
+      {
+         static constexpr size_t stages = 2;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0 },
+            { 1.0, 0.0 } };
+         static constexpr double b[stages] = { 0.5, 0.5 };
+         static constexpr double c[stages] = { 0.0, 1.0 };
+      };
+
+      // Heun's third order method
+      struct RK3
+      {
+         static constexpr size_t stages = 3;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0, 0.0 },
+            { 1.0 / 3.0, 0.0, 0.0 },
+            { 0.0, 2.0 / 3.0, 0.0 } };
+         static constexpr double b[stages] = { 1.0 / 4.0, 0.0, 3.0 / 4.0 };
+         static constexpr double c[stages] = { 0.0, 1.0 / 3.0, 2.0 / 3.0 };
+      };
+
+      // Third order strong stability preserving method of Shu and Osher
+      struct SSPRK3
+      {
+         static constexpr size_t stages = 3;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0, 0.0 },
+            { 1.0, 0.0, 0.0 },
+            { 0.25, 0.25, 0.0 } };
+         static constexpr double b[stages] = { 1.0 / 6.0, 1.0 / 6.0, 2.0 / 3.0 };
+         static constexpr double c[stages] = { 0.0, 1.0, 0.5 };
+      };
+
+      // Classic fourth order Runge Kutta
+      struct RK4
+      {
+         static constexpr size_t stages = 4;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0, 0.0, 0.0 },
+            { 0.5, 0.0, 0.0, 0.0 },
+            { 0.0, 0.5, 0.0, 0.0 },
+            { 0.0, 0.0, 1.0, 0.0 } };
+         static constexpr double b[stages] = { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+         static constexpr double c[stages] = { 0.0, 0.5, 0.5, 1.0 };
+      };
+
+      // Kutta's 3/8 rule, the NCRK4 method
+      struct RK38
+      {
+         static constexpr size_t stages = 4;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0, 0.0, 0.0 },
+            { 1.0 / 3.0, 0.0, 0.0, 0.0 },
+            { -1.0 / 3.0, 1.0, 0.0, 0.0 },
+            { 1.0, -1.0, 1.0, 0.0 } };
+         static constexpr double b[stages] = { 1.0 / 8.0, 3.0 / 8.0, 3.0 / 8.0, 1.0 / 8.0 };
+         static constexpr double c[stages] = { 0.0, 1.0 / 3.0, 2.0 / 3.0, 1.0 };
+      };
+
+      // Ralston's fourth order method, minimum truncation error
+      struct Ralston4
+      {
+         static constexpr size_t stages = 4;
+         static constexpr double a[stages][stages] = {
+            { 0.0, 0.0, 0.0, 0.0 },
+            { 0.4, 0.0, 0.0, 0.0 },
+            { 0.29697761, 0.15875964, 0.0, 0.0 },
+            { 0.21810040, -3.05096516, 3.83286476, 0.0 } };
+         static constexpr double b[stages] = { 0.17476028, -0.55148066, 1.20553560, 0.17118478 };
+         static constexpr double c[stages] = { 0.0, 0.4, 0.45573725, 1.0 };
+      };
+
+      // Williamson's third order, three stage 2N scheme
+      struct Williamson3
+      {
+         static constexpr size_t stages = 3;
+         static constexpr double A[stages] = { 0.0, -5.0 / 9.0, -153.0 / 128.0 };
+         static constexpr double B[stages] = { 1.0 / 3.0, 15.0 / 16.0, 8.0 / 15.0 };
+         static constexpr double C[stages] = { 0.0, 1.0 / 3.0, 3.0 / 4.0 };
+      };
+
+      // Carpenter and Kennedy's fourth order, five stage 2N scheme RK4(3)5, solution 3 of NASA TM-109112.
+      // The error weights compare against the third order embedded solution with a zero second weight.
+      struct CK45
+      {
+         static constexpr size_t stages = 5;
+         static constexpr double A[stages] = { 0.0, -567301805773.0 / 1357537059087.0, -2404267990393.0 / 2016746695238.0, -3550918686646.0 / 2091501179385.0, -1275806237668.0 / 842570457699.0 };
+         static constexpr double B[stages] = { 1432997174477.0 / 9575080441755.0, 5161836677717.0 / 13612068292357.0, 1720146321549.0 / 2090206949498.0, 3134564353537.0 / 4481467310338.0, 2277821191437.0 / 14882151754819.0 };
+         static constexpr double C[stages] = { 0.0, 1432997174477.0 / 9575080441755.0, 2526269341429.0 / 6820363962896.0, 2006345519317.0 / 3224310063776.0, 2802321613138.0 / 2924317926251.0 };
+         static constexpr double E[stages] = { -0.16033435641008234, 0.34474304234056707, -0.24407312659415953, 0.054651527079573693, 0.0050129135841011242 };
+         static constexpr size_t embedded_order = 3;
+      };
+
+      // Hairer and Wanner's L-stable SDIRK4 (Solving ODEs II, Table 6.5), stiffly accurate with a third order embedded solution.
+      // a includes the diagonal gamma, bhat are the embedded weights.
+      struct SDIRK4
+      {
+         static constexpr size_t stages = 5;
+         static constexpr double gamma = 1.0 / 4.0;
+         static constexpr double a[stages][stages] = {
+            { 1.0 / 4.0, 0.0, 0.0, 0.0, 0.0 },
+            { 1.0 / 2.0, 1.0 / 4.0, 0.0, 0.0, 0.0 },
+            { 17.0 / 50.0, -1.0 / 25.0, 1.0 / 4.0, 0.0, 0.0 },
+            { 371.0 / 1360.0, -137.0 / 2720.0, 15.0 / 544.0, 1.0 / 4.0, 0.0 },
+            { 25.0 / 24.0, -49.0 / 48.0, 125.0 / 16.0, -85.0 / 12.0, 1.0 / 4.0 } };
+         static constexpr double b[stages] = { 25.0 / 24.0, -49.0 / 48.0, 125.0 / 16.0, -85.0 / 12.0, 1.0 / 4.0 };
+         static constexpr double bhat[stages] = { 59.0 / 48.0, -17.0 / 96.0, 225.0 / 32.0, -85.0 / 12.0, 0.0 };
+         static constexpr double c[stages] = { 1.0 / 4.0, 3.0 / 4.0, 11.0 / 20.0, 1.0 / 2.0, 1.0 };
+         static constexpr size_t order = 4;
+         static constexpr size_t embedded_order = 3;
+      };
+
+      // Rang and Angermann's ROS34PW2, a third order Rosenbrock-W method with a second order embedded solution, L-stable and stiffly accurate.
+      // Rosenbrock form: (I - gamma * h * J) k_i = h * f(x + sum alpha_ij k_j) + h * J * sum g_ij k_j, x_new = x + sum b_i k_i.
+      // As a W-method it keeps its order with an approximate Jacobian, so Jacobians can be kept across steps.
+      struct ROS34PW2
+      {
+         static constexpr size_t stages = 4;
+         static constexpr double gamma = 4.3586652150845900e-01;
+         static constexpr double alpha[stages][stages] = {
+            { 0.0, 0.0, 0.0, 0.0 },
+            { 8.7173304301691801e-01, 0.0, 0.0, 0.0 },
+            { 8.4457060015369423e-01, -1.1299064236484185e-01, 0.0, 0.0 },
+            { 0.0, 0.0, 1.0, 0.0 } };
+         static constexpr double g[stages][stages] = {
+            { 0.0, 0.0, 0.0, 0.0 },
+            { -8.7173304301691801e-01, 0.0, 0.0, 0.0 },
+            { -9.0338057013044082e-01, 5.4180672388095326e-02, 0.0, 0.0 },
+            { 2.4212380706095346e-01, -1.2232505839045147e+00, 5.4526025533510214e-01, 0.0 } };
+         static constexpr double b[stages] = { 2.4212380706095346e-01, -1.2232505839045147e+00, 1.5452602553351020e+00, 4.3586652150845900e-01 };
+         static constexpr double bhat[stages] = { 3.7810903145819369e-01, -9.6042292212423178e-02, 5.0000000000000000e-01, 2.1793326075422950e-01 };
+         static constexpr size_t order = 3;
+         static constexpr size_t embedded_order = 2;
+      };
+
+      // Weights of row i of a tableau (i == stages gives b), the column of each nonzero weight in order
+      template <class tableau_t, size_t i>
+      constexpr auto nonzero() noexcept
+      {
+         constexpr auto weight = [](const size_t j) { if constexpr (i < tableau_t::stages) return tableau_t::a[i][j]; else return tableau_t::b[j]; };
+         constexpr size_t n_columns = i < tableau_t::stages ? i : tableau_t::stages;
+         constexpr size_t n = [&] {
+            size_t count{};
+            for (size_t j = 0; j < n_columns; ++j) {
+               if (weight(j) != 0.0) ++count;
+            }
+            return count;
+         }();
+
+         std::array<size_t, n> columns{};
+         size_t k{};
+         for (size_t j = 0; j < n_columns; ++j) {
+            if (weight(j) != 0.0) columns[k++] = j;
+         }
+         return columns;
+      }
+
+      // Calls f(std::index_sequence<j...>) with the columns of the nonzero weights of row i, zero weights are pruned at compile time
+      template <class tableau_t, size_t i, class F>
+      constexpr decltype(auto) with_nonzero(F&& f)
+      {
+         constexpr auto columns = nonzero<tableau_t, i>();
+         return [&]<size_t... K>(std::index_sequence<K...>) -> decltype(auto) {
+            return f(std::index_sequence<columns[K]...>{});
+         }(std::make_index_sequence<columns.size()>{});
+      }
+
+      // Weight of column j in row i, i == stages gives b
+      template <class tableau_t, size_t i, size_t j>
+      inline constexpr double weight = [] { if constexpr (i < tableau_t::stages) return tableau_t::a[i][j]; else return tableau_t::b[j]; }();
+   }
+}
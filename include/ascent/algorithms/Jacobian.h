@@ -0,0 +1,426 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/LinearAlgebra.h"
+#include "ascent/algorithms/Sparse.h"
+#include "ascent/threading/Pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Jacobians and Newton iteration matrices for the implicit integrators.
+// A system may supply its Jacobian through a member jacobian(x, J, t) filling a MatrixT, otherwise it is estimated by forward differences.
+// Large sparse systems are estimated column group by column group: the sparsity pattern is detected once by probing the system and
+// columns that share no row are perturbed together, so a banded system costs a few evaluations per Jacobian rather than one per state.
+// Column groups are independent, so with a pool they are spread over its threads for systems declared thread safe.
+
+namespace asc
+{
+   template <class state_t>
+   struct JacobianT
+   {
+      using value_t = typename state_t::value_type;
+
+      // J = df/dx at (x, t), xd is the derivative at (x, t)
+      template <class System>
+      void operator()(System& system, const state_t& x, const state_t& xd, const value_t t, MatrixT<value_t>& J)
+      {
+         const size_t n = x.size();
+         if (J.size() != n) {
+            J.resize(n);
+         }
+
+         if constexpr (requires { system.jacobian(x, J, t); })
+         {
+            system.jacobian(x, J, t);
+         }
+         else
+         {
+            groups(system, n, x, [&](state_t& xp, state_t& xdp, const size_t begin, const size_t end) {
+               for (size_t j = begin; j < end; ++j)
+               {
+                  const value_t h = delta(x[j]);
+                  xp[j] = x[j] + h;
+                  system(xp, xdp, t);
+                  xp[j] = x[j];
+
+                  const value_t inv = 1 / h;
+                  for (size_t i = 0; i < n; ++i) {
+                     J(i, j) = (xdp[i] - xd[i]) * inv;
+                  }
+               }
+            });
+            evaluations += n;
+         }
+      }
+
+      // J = df/dx at (x, t) in the detected pattern, one evaluation per color
+      template <class System>
+      void operator()(System& system, const state_t& x, const state_t& xd, const value_t t, SparseMatrixT<value_t>& J)
+      {
+         const size_t n = x.size();
+         if (col_ptr.size() != n + 1) {
+            index();
+         }
+
+         groups(system, n_colors, x, [&](state_t& xp, state_t& xdp, const size_t begin, const size_t end) {
+            for (size_t c = begin; c < end; ++c)
+            {
+               for (size_t m = color_ptr[c]; m < color_ptr[c + 1]; ++m)
+               {
+                  const size_t j = color_cols[m];
+                  xp[j] = x[j] + delta(x[j]);
+               }
+               system(xp, xdp, t);
+
+               for (size_t m = color_ptr[c]; m < color_ptr[c + 1]; ++m)
+               {
+                  const size_t j = color_cols[m];
+                  const value_t inv = 1 / (xp[j] - x[j]);
+                  for (size_t r = col_ptr[j]; r < col_ptr[j + 1]; ++r)
+                  {
+                     const size_t i = col_rows[r];
+                     J.values[col_pos[r]] = (xdp[i] - xd[i]) * inv;
+                  }
+                  xp[j] = x[j];
+               }
+            }
+         });
+         evaluations += n_colors;
+      }
+
+      // Detects the sparsity pattern by probing and colors its columns. The system is evaluated at a shifted copy of x and once more
+      // with each component perturbed, every derivative that changes marks a nonzero. The shift keeps nonzeros that vanish at x itself,
+      // e.g. a product with a state that is zero. Costs n + 1 evaluations, once.
+      template <class System>
+      void detect(System& system, const state_t& x, const value_t t)
+      {
+         const size_t n = x.size();
+         const value_t probe = std::cbrt(std::numeric_limits<value_t>::epsilon());
+         state_t xs = x;
+         for (size_t j = 0; j < n; ++j) {
+            xs[j] += probe * std::max(value_t(1), std::abs(x[j]));
+         }
+         state_t xds = x;
+         system(xs, xds, t);
+
+         std::vector<std::vector<size_t>> changed(n); // rows of every column
+         groups(system, n, xs, [&](state_t& xp, state_t& xdp, const size_t begin, const size_t end) {
+            for (size_t j = begin; j < end; ++j)
+            {
+               xp[j] = xs[j] + probe * std::max(value_t(1), std::abs(xs[j]));
+               system(xp, xdp, t);
+               xp[j] = xs[j];
+
+               for (size_t i = 0; i < n; ++i) {
+                  if (xdp[i] != xds[i]) changed[j].emplace_back(i);
+               }
+            }
+         });
+         evaluations += n + 1;
+
+         std::vector<std::vector<size_t>> rows(n);
+         for (size_t j = 0; j < n; ++j) {
+            for (auto i : changed[j]) rows[i].emplace_back(j);
+         }
+         pattern.assign(rows);
+         n_colors = color_columns(pattern, colors);
+         index();
+      }
+
+      // Forward difference perturbation of a component (Hairer and Wanner's RADAU5)
+      static value_t delta(const value_t x) noexcept
+      {
+         return std::sqrt(std::numeric_limits<value_t>::epsilon() * std::max(value_t(1.0e-5), std::abs(x)));
+      }
+
+      size_t evaluations{}; // system evaluations spent on finite differences
+
+      SparsityPattern pattern; // detected nonzeros
+      std::vector<size_t> colors; // color of every column
+      size_t n_colors{};
+
+      // If set, columns (or colors of a sparse Jacobian) are evaluated in parallel for systems declared thread safe, see is_thread_safe.
+      // Every task perturbs its own copy of the state.
+      Pool* pool{};
+
+   private:
+      struct Scratch
+      {
+         state_t x{}, xd{};
+      };
+      std::vector<Scratch> scratch; // one per pool task
+
+      // columns of color c are color_cols[color_ptr[c]] to color_cols[color_ptr[c + 1] - 1]
+      std::vector<size_t> color_ptr, color_cols;
+      // nonzeros of column j are in rows col_rows[r] at pattern.cols[col_pos[r]], for r in [col_ptr[j], col_ptr[j + 1])
+      std::vector<size_t> col_ptr, col_rows, col_pos;
+
+      // Calls f(xp, xdp, begin, end) on chunks of [0, n_groups), where xp is a private copy of x and xdp private derivative storage
+      template <class System, class F>
+      void groups(System&, const size_t n_groups, const state_t& x, F&& f)
+      {
+         auto run = [&](const size_t k, const size_t begin, const size_t end) {
+            auto& s = scratch[k];
+            s.x = x;
+            resize(s.xd, x.size());
+            f(s.x, s.xd, begin, end);
+         };
+
+         if constexpr (is_thread_safe_v<System>)
+         {
+            if (pool && pool->size() > 0)
+            {
+               scratch.resize(pool->size() + 1);
+               pool->parallel_chunks(n_groups, 1, run);
+               return;
+            }
+         }
+         scratch.resize(std::max<size_t>(scratch.size(), 1));
+         if (n_groups > 0) {
+            run(0, 0, n_groups);
+         }
+      }
+
+      // Column and color indices of the pattern, so a sparse Jacobian visits every nonzero once
+      void index()
+      {
+         const size_t n = pattern.size();
+         col_ptr.assign(n + 1, 0);
+         for (auto j : pattern.cols) {
+            ++col_ptr[j + 1];
+         }
+         for (size_t j = 0; j < n; ++j) {
+            col_ptr[j + 1] += col_ptr[j];
+         }
+         col_rows.resize(pattern.nnz());
+         col_pos.resize(pattern.nnz());
+         std::vector<size_t> fill(col_ptr.begin(), col_ptr.end() - 1);
+         for (size_t i = 0; i < n; ++i)
+         {
+            for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k)
+            {
+               const size_t r = fill[pattern.cols[k]]++;
+               col_rows[r] = i;
+               col_pos[r] = k;
+            }
+         }
+
+         color_ptr.assign(n_colors + 1, 0);
+         for (auto c : colors) {
+            ++color_ptr[c + 1];
+         }
+         for (size_t c = 0; c < n_colors; ++c) {
+            color_ptr[c + 1] += color_ptr[c];
+         }
+         color_cols.resize(n);
+         fill.assign(color_ptr.begin(), color_ptr.end() - 1);
+         for (size_t j = 0; j < n; ++j) {
+            color_cols[fill[colors[j]]++] = j;
+         }
+      }
+   };
+
+   // Newton iteration matrix I - c * J of the implicit integrators.
+   // The Jacobian is kept until it is refreshed and its LU factorization until c or the Jacobian changes, so both are reused across steps.
+   // On the first refresh of a system without an analytic Jacobian and at least sparse_min states the sparsity pattern is detected.
+   // If its coloring needs at most half as many evaluations as there are states, the Jacobian is estimated by colors and factored by a sparse LU.
+   // The sparse LU does not pivot, a factorization that would need pivoting is repeated by the pivoting dense LU.
+   template <class state_t>
+   struct IterationMatrixT
+   {
+      using value_t = typename state_t::value_type;
+
+      JacobianT<state_t> jacobian;
+      MatrixT<value_t> J;
+      SparseMatrixT<value_t> J_sparse; // the Jacobian if sparse
+
+      bool sparse = false; // decided on the first refresh
+      size_t sparse_min = 32; // systems with fewer states keep a dense Jacobian
+      bool current = false; // the Jacobian was evaluated at the start of the current step
+      size_t n_jacobians{};
+      size_t n_factorizations{};
+      size_t n_dense_fallbacks{}; // sparse factorizations repeated by the dense LU
+
+      size_t size() const noexcept { return sparse ? J_sparse.size() : J.size(); }
+      bool empty() const noexcept { return size() == 0; }
+
+      // Infinity norm of the Jacobian, a bound of its spectral radius
+      value_t norm() const noexcept
+      {
+         value_t result{};
+         for (size_t i = 0; i < size(); ++i)
+         {
+            value_t s{};
+            if (sparse)
+            {
+               for (size_t k = J_sparse.pattern.row_ptr[i]; k < J_sparse.pattern.row_ptr[i + 1]; ++k) {
+                  s += std::abs(J_sparse.values[k]);
+               }
+            }
+            else
+            {
+               const value_t* J_i = J.row(i);
+               for (size_t j = 0; j < J.size(); ++j) {
+                  s += std::abs(J_i[j]);
+               }
+            }
+            result = std::max(result, s);
+         }
+         return result;
+      }
+
+      // Forgets the Jacobian and its pattern, e.g. when the structure of the system changes
+      void reset()
+      {
+         J = {};
+         J_sparse = {};
+         sparse = false;
+         dense_fallback = false;
+         factored = false;
+      }
+
+      template <class System>
+      void refresh(System& system, const state_t& x, const state_t& xd, const value_t t)
+      {
+         if (size() != x.size()) {
+            structure(system, x, t);
+         }
+
+         if (sparse) {
+            jacobian(system, x, xd, t, J_sparse);
+         }
+         else {
+            jacobian(system, x, xd, t, J);
+         }
+         ++n_jacobians;
+         current = true;
+         factored = false;
+      }
+
+      // Factors I - c * J unless it is already factored for c, returns false if it is singular
+      bool factor(const value_t c)
+      {
+         if (factored && c == c_factored) {
+            return true;
+         }
+
+         ++n_factorizations;
+         c_factored = c;
+         if (sparse)
+         {
+            const auto& pattern = J_sparse.pattern;
+            for (size_t i = 0; i < pattern.size(); ++i)
+            {
+               for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+                  M_sparse.values[k] = (pattern.cols[k] == i ? value_t(1) : value_t{}) - c * J_sparse.values[k];
+               }
+            }
+            dense_fallback = !lu_sparse.factor(M_sparse);
+            if (!dense_fallback)
+            {
+               factored = true;
+               return true;
+            }
+
+            ++n_dense_fallbacks;
+            const size_t n = pattern.size();
+            M.resize(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+               value_t* M_i = M.row(i);
+               std::fill(M_i, M_i + n, value_t{});
+               for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+                  M_i[pattern.cols[k]] = M_sparse.values[k];
+               }
+            }
+            factored = lu.factor(M);
+            return factored;
+         }
+
+         const size_t n = J.size();
+         M.resize(n);
+         for (size_t i = 0; i < n; ++i)
+         {
+            const value_t* J_i = J.row(i);
+            value_t* M_i = M.row(i);
+            for (size_t j = 0; j < n; ++j) {
+               M_i[j] = -c * J_i[j];
+            }
+            M_i[i] += 1;
+         }
+
+         factored = lu.factor(M);
+         return factored;
+      }
+
+      // Solves (I - c * J) x = b in place
+      void solve(state_t& b) const
+      {
+         if (sparse && !dense_fallback) {
+            lu_sparse.solve(b);
+         }
+         else {
+            lu.solve(b);
+         }
+      }
+
+   private:
+      MatrixT<value_t> M;
+      LUT<value_t> lu;
+      SparseMatrixT<value_t> M_sparse;
+      SparseLUT<value_t> lu_sparse;
+      bool dense_fallback = false; // the current sparse factorization is held by the dense LU
+      bool factored = false;
+      value_t c_factored{};
+
+      // Chooses between the dense and the sparse Jacobian for a system of x.size() states
+      template <class System>
+      void structure(System& system, const state_t& x, const value_t t)
+      {
+         const size_t n = x.size();
+         sparse = false;
+         if constexpr (!requires { system.jacobian(x, J, t); })
+         {
+            if (n >= sparse_min)
+            {
+               jacobian.detect(system, x, t);
+               sparse = 2 * jacobian.n_colors <= n;
+            }
+         }
+
+         if (sparse)
+         {
+            J_sparse.assign(jacobian.pattern);
+            M_sparse.assign(jacobian.pattern);
+            lu_sparse.analyze(jacobian.pattern);
+            J = {};
+         }
+         else {
+            J.resize(n);
+         }
+      }
+   };
+
+   // Convergence tolerance of the simplified Newton iterations on the scaled error norm (Hairer and Wanner, Shampine)
+   template <class value_t>
+   inline value_t newton_tolerance(const AdaptiveT<value_t>& settings) noexcept
+   {
+      return std::max(10 * std::numeric_limits<value_t>::epsilon() / settings.rel_tol, std::min(value_t(0.03), std::sqrt(settings.rel_tol)));
+   }
+}
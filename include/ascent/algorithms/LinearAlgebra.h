@@ -0,0 +1,141 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Dense linear algebra for the implicit integrators: a row-major matrix and an LU factorization with partial pivoting.
+
+namespace asc
+{
+   template <class value_t>
+   struct MatrixT
+   {
+      MatrixT() = default;
+      MatrixT(const size_t n) : n(n), data(n * n) {}
+
+      size_t size() const noexcept { return n; }
+
+      void resize(const size_t n_rows)
+      {
+         n = n_rows;
+         data.assign(n * n, value_t{});
+      }
+
+      value_t& operator()(const size_t i, const size_t j) noexcept { return data[i * n + j]; }
+      const value_t& operator()(const size_t i, const size_t j) const noexcept { return data[i * n + j]; }
+
+      value_t* row(const size_t i) noexcept { return data.data() + i * n; }
+      const value_t* row(const size_t i) const noexcept { return data.data() + i * n; }
+
+      size_t n{};
+      std::vector<value_t> data;
+   };
+
+   // LU factorization with partial pivoting, factored once and solved against many right hand sides
+   template <class value_t>
+   struct LUT
+   {
+      // Factors a copy of A, returns false if A is singular to working precision
+      bool factor(const MatrixT<value_t>& A)
+      {
+         lu = A;
+         const size_t n = A.size();
+         pivots.resize(n);
+
+         for (size_t k = 0; k < n; ++k)
+         {
+            size_t p = k;
+            value_t p_max = std::abs(lu(k, k));
+            for (size_t i = k + 1; i < n; ++i)
+            {
+               const value_t v = std::abs(lu(i, k));
+               if (v > p_max)
+               {
+                  p_max = v;
+                  p = i;
+               }
+            }
+            pivots[k] = p;
+            if (p_max == value_t{}) {
+               return false;
+            }
+            if (p != k)
+            {
+               for (size_t j = 0; j < n; ++j) {
+                  std::swap(lu(k, j), lu(p, j));
+               }
+            }
+
+            const value_t inv = 1 / lu(k, k);
+            const value_t* row_k = lu.row(k);
+            for (size_t i = k + 1; i < n; ++i)
+            {
+               value_t* row_i = lu.row(i);
+               const value_t l = row_i[k] *= inv;
+               if (l != value_t{})
+               {
+                  for (size_t j = k + 1; j < n; ++j) {
+                     row_i[j] -= l * row_k[j];
+                  }
+               }
+            }
+         }
+         return true;
+      }
+
+      // Solves A x = b in place
+      template <class state_t>
+      void solve(state_t& b) const
+      {
+         const size_t n = lu.size();
+         for (size_t k = 0; k < n; ++k)
+         {
+            if (pivots[k] != k) {
+               std::swap(b[k], b[pivots[k]]);
+            }
+         }
+
+         for (size_t i = 1; i < n; ++i)
+         {
+            const value_t* row_i = lu.row(i);
+            value_t s = b[i];
+            for (size_t j = 0; j < i; ++j) {
+               s -= row_i[j] * b[j];
+            }
+            b[i] = s;
+         }
+
+         for (size_t i = n; i-- > 0;)
+         {
+            const value_t* row_i = lu.row(i);
+            value_t s = b[i];
+            for (size_t j = i + 1; j < n; ++j) {
+               s -= row_i[j] * b[j];
+            }
+            b[i] = s / row_i[i];
+         }
+      }
+
+      size_t size() const noexcept { return lu.size(); }
+
+   private:
+      MatrixT<value_t> lu;
+      std::vector<size_t> pivots;
+   };
+}
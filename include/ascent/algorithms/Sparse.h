@@ -0,0 +1,249 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <set>
+#include <vector>
+
+// Sparse linear algebra for the implicit integrators: compressed sparse row (CSR) patterns and matrices, column coloring for
+// finite difference Jacobians (Curtis, Powell and Reid) and an LU factorization that keeps the fill of the pattern.
+
+namespace asc
+{
+   // Nonzero structure of an n x n matrix, the columns of row i are cols[row_ptr[i]] to cols[row_ptr[i + 1] - 1] in ascending order
+   struct SparsityPattern
+   {
+      size_t n{};
+      std::vector<size_t> row_ptr{ 0 };
+      std::vector<size_t> cols;
+
+      size_t size() const noexcept { return n; }
+      size_t nnz() const noexcept { return cols.size(); }
+      bool empty() const noexcept { return n == 0; }
+
+      void clear()
+      {
+         n = 0;
+         row_ptr.assign(1, 0);
+         cols.clear();
+      }
+
+      // Builds the pattern from the columns of every row, which are sorted and deduplicated. The diagonal is always included.
+      void assign(std::vector<std::vector<size_t>>& rows)
+      {
+         n = rows.size();
+         row_ptr.assign(1, 0);
+         cols.clear();
+         for (size_t i = 0; i < n; ++i)
+         {
+            auto& row = rows[i];
+            row.emplace_back(i);
+            std::sort(row.begin(), row.end());
+            row.erase(std::unique(row.begin(), row.end()), row.end());
+            cols.insert(cols.end(), row.begin(), row.end());
+            row_ptr.emplace_back(cols.size());
+         }
+      }
+
+      // Position of (i, j) within cols, nnz() if it is not in the pattern
+      size_t find(const size_t i, const size_t j) const noexcept
+      {
+         const auto first = cols.begin() + row_ptr[i];
+         const auto last = cols.begin() + row_ptr[i + 1];
+         const auto it = std::lower_bound(first, last, j);
+         return (it != last && *it == j) ? static_cast<size_t>(it - cols.begin()) : nnz();
+      }
+   };
+
+   // Greedy coloring of the columns of a pattern so that no two columns of a color share a row.
+   // The columns of a color can be perturbed together, so a finite difference Jacobian needs one evaluation per color. Returns the number of colors.
+   inline size_t color_columns(const SparsityPattern& pattern, std::vector<size_t>& colors)
+   {
+      const size_t n = pattern.size();
+
+      // rows of every column
+      std::vector<size_t> col_ptr(n + 1), rows(pattern.nnz());
+      for (auto j : pattern.cols) {
+         ++col_ptr[j + 1];
+      }
+      for (size_t j = 0; j < n; ++j) {
+         col_ptr[j + 1] += col_ptr[j];
+      }
+      std::vector<size_t> fill(col_ptr.begin(), col_ptr.end() - 1);
+      for (size_t i = 0; i < n; ++i)
+      {
+         for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+            rows[fill[pattern.cols[k]]++] = i;
+         }
+      }
+
+      constexpr size_t none = static_cast<size_t>(-1);
+      colors.assign(n, none);
+      std::vector<size_t> forbidden(n + 1, none); // forbidden[c] == j if color c is taken by a column sharing a row with column j
+      size_t n_colors{};
+      for (size_t j = 0; j < n; ++j)
+      {
+         for (size_t r = col_ptr[j]; r < col_ptr[j + 1]; ++r)
+         {
+            const size_t i = rows[r];
+            for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k)
+            {
+               const size_t c = colors[pattern.cols[k]];
+               if (c != none) {
+                  forbidden[c] = j;
+               }
+            }
+         }
+
+         size_t c{};
+         while (forbidden[c] == j) {
+            ++c;
+         }
+         colors[j] = c;
+         n_colors = std::max(n_colors, c + 1);
+      }
+      return n_colors;
+   }
+
+   // Square matrix in compressed sparse row form
+   template <class value_t>
+   struct SparseMatrixT
+   {
+      SparsityPattern pattern;
+      std::vector<value_t> values; // in the order of pattern.cols
+
+      size_t size() const noexcept { return pattern.size(); }
+
+      void assign(const SparsityPattern& p)
+      {
+         pattern = p;
+         values.assign(p.nnz(), value_t{});
+      }
+   };
+
+   // LU factorization of a sparse matrix without pivoting, suited to the diagonally weighted iteration matrices I - c * J.
+   // factor() fails rather than divide by a pivot that would need pivoting, callers then fall back to a pivoting dense LU.
+   // analyze() computes the pattern of L + U including its fill once, factor() then only repeats the numeric elimination.
+   template <class value_t>
+   struct SparseLUT
+   {
+      // Symbolic factorization of a pattern, which must contain the diagonal
+      void analyze(const SparsityPattern& A)
+      {
+         const size_t n = A.size();
+         std::vector<std::vector<size_t>> rows(n);
+         for (size_t i = 0; i < n; ++i)
+         {
+            std::set<size_t> row(A.cols.begin() + A.row_ptr[i], A.cols.begin() + A.row_ptr[i + 1]);
+            for (auto it = row.begin(); it != row.end() && *it < i; ++it)
+            {
+               const auto& upper = rows[*it]; // row k of U contributes its columns beyond k
+               for (auto j : upper) {
+                  if (j > *it) row.insert(j);
+               }
+            }
+            rows[i].assign(row.begin(), row.end());
+         }
+         lu.assign(rows);
+
+         diag.resize(n);
+         for (size_t i = 0; i < n; ++i) {
+            diag[i] = lu.find(i, i);
+         }
+         values.assign(lu.nnz(), value_t{});
+         work.assign(n, value_t{});
+      }
+
+      bool analyzed() const noexcept { return !lu.empty(); }
+
+      value_t pivot_tolerance = static_cast<value_t>(1.0e-8); // smallest pivot relative to the largest magnitude of its row of A
+
+      // Numeric factorization of A, whose pattern was analyzed. Returns false on a zero, tiny or non-finite pivot, which needs pivoting.
+      bool factor(const SparseMatrixT<value_t>& A)
+      {
+         const size_t n = lu.size();
+         const auto& ap = A.pattern;
+         for (size_t i = 0; i < n; ++i)
+         {
+            const size_t begin = lu.row_ptr[i];
+            const size_t end = lu.row_ptr[i + 1];
+            for (size_t k = begin; k < end; ++k) {
+               work[lu.cols[k]] = value_t{};
+            }
+            value_t row_max{};
+            for (size_t k = ap.row_ptr[i]; k < ap.row_ptr[i + 1]; ++k)
+            {
+               work[ap.cols[k]] = A.values[k];
+               row_max = std::max(row_max, std::abs(A.values[k]));
+            }
+
+            for (size_t k = begin; k < diag[i]; ++k)
+            {
+               const size_t p = lu.cols[k];
+               const value_t l = work[p] /= values[diag[p]];
+               if (l != value_t{})
+               {
+                  for (size_t q = diag[p] + 1; q < lu.row_ptr[p + 1]; ++q) {
+                     work[lu.cols[q]] -= l * values[q];
+                  }
+               }
+            }
+
+            for (size_t k = begin; k < end; ++k) {
+               values[k] = work[lu.cols[k]];
+            }
+            const value_t pivot = values[diag[i]];
+            if (!(std::abs(pivot) > pivot_tolerance * row_max) || !std::isfinite(pivot)) {
+               return false;
+            }
+         }
+         return true;
+      }
+
+      // Solves A x = b in place
+      template <class vector_t>
+      void solve(vector_t& b) const
+      {
+         const size_t n = lu.size();
+         for (size_t i = 0; i < n; ++i)
+         {
+            value_t s = b[i];
+            for (size_t k = lu.row_ptr[i]; k < diag[i]; ++k) {
+               s -= values[k] * b[lu.cols[k]];
+            }
+            b[i] = s;
+         }
+         for (size_t i = n; i-- > 0;)
+         {
+            value_t s = b[i];
+            for (size_t k = diag[i] + 1; k < lu.row_ptr[i + 1]; ++k) {
+               s -= values[k] * b[lu.cols[k]];
+            }
+            b[i] = s / values[diag[i]];
+         }
+      }
+
+      size_t nnz() const noexcept { return lu.nnz(); } // nonzeros of L + U, including the fill
+
+   private:
+      SparsityPattern lu; // pattern of L + U
+      std::vector<size_t> diag; // position of the diagonal of every row
+      std::vector<value_t> values;
+      std::vector<value_t> work;
+   };
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace asc
+{
+   // Step size controller shared by the adaptive integrators, in the filter form of Soderlind:
+   // dt *= safety_factor * e[n]^(-beta1 / k) * e[n-1]^(-beta2 / k) * e[n-2]^(-beta3 / k)
+   // where e is the error norm of a step relative to the tolerances (accepted if e <= 1) and the error estimate is O(dt^k).
+   // Rejected steps are reduced by the elementary controller, and the step following a rejection may not grow.
+   template <class value_t>
+   struct StepControllerT
+   {
+      constexpr StepControllerT() noexcept = default;
+      constexpr StepControllerT(const value_t beta1, const value_t beta2, const value_t beta3) noexcept : beta1(beta1), beta2(beta2), beta3(beta3) {}
+
+      value_t beta1 = 1.0_v;
+      value_t beta2{};
+      value_t beta3{};
+      value_t min_factor = 0.2_v; // bounds of the step size change
+      value_t max_factor = 5.0_v;
+
+      // Elementary (integral) controller
+      static constexpr StepControllerT I() noexcept { return{ 1.0_v, 0.0_v, 0.0_v }; }
+      // Gustafsson's PI controller, smooths step sizes and avoids repeated rejections
+      static constexpr StepControllerT PI() noexcept { return{ 0.7_v, -0.4_v, 0.0_v }; }
+      // PID controller, for problems where the PI controller still oscillates
+      static constexpr StepControllerT PID() noexcept { return{ 0.49_v, -0.34_v, 0.1_v }; }
+
+      // Returns the step size factor for an error norm e, e > 1 rejects the step
+      value_t operator()(const value_t e, const value_t k, const value_t safety_factor) noexcept
+      {
+         const value_t e_n = std::max(e, 1.0e-10_v); // an exact step must not divide by zero
+
+         if (e_n > 1.0_v)
+         {
+            rejected = true;
+            return std::clamp(safety_factor * std::pow(e_n, -1.0_v / k), min_factor, 1.0_v);
+         }
+
+         value_t factor = safety_factor * std::pow(e_n, -beta1 / k);
+         if (beta2 != 0.0_v) {
+            factor *= std::pow(e1, -beta2 / k);
+         }
+         if (beta3 != 0.0_v) {
+            factor *= std::pow(e2, -beta3 / k);
+         }
+
+         e2 = e1;
+         e1 = e_n;
+         factor = std::clamp(factor, min_factor, rejected ? 1.0_v : max_factor);
+         rejected = false;
+         return factor;
+      }
+
+      // Forgets the error history, e.g. after a discontinuity
+      void reset() noexcept
+      {
+         e1 = e2 = 1.0_v;
+         rejected = false;
+      }
+
+   private:
+      value_t e1 = 1.0_v; // error norms of the previous accepted steps
+      value_t e2 = 1.0_v;
+      bool rejected = false;
+   };
+
+   // Starting step size of Hairer, Norsett and Wanner (Solving ODEs I, II.4) for a method of the given order, costs one evaluation of the system.
+   // xd0 is the derivative at (x0, t0), x1 and xd1 are scratch. Components are scaled by their tolerances as in simd::error_norm.
+   template <class state_t, class System, class value_t = typename state_t::value_type>
+   value_t initial_step(System&& system, const state_t& x0, const state_t& xd0, state_t& x1, state_t& xd1, const value_t t0, const size_t order, const AdaptiveT<value_t>& settings)
+   {
+      const size_t n = x0.size();
+      const size_t n_abs = std::min(n, settings.abs_tols.size());
+      const size_t n_rel = std::min(n, settings.rel_tols.size());
+      auto scale = [&](const size_t i) {
+         const value_t a = i < n_abs ? settings.abs_tols[i] : settings.abs_tol;
+         const value_t r = i < n_rel ? settings.rel_tols[i] : settings.rel_tol;
+         return a + r * std::abs(x0[i]); // infinite for components excluded from error control, which then count as zero
+      };
+
+      value_t d0{}, d1{};
+      for (size_t i = 0; i < n; ++i)
+      {
+         const value_t sc = scale(i);
+         d0 += (x0[i] / sc) * (x0[i] / sc);
+         d1 += (xd0[i] / sc) * (xd0[i] / sc);
+      }
+      d0 = std::sqrt(d0 / n);
+      d1 = std::sqrt(d1 / n);
+
+      const value_t h0 = (d0 < 1.0e-5_v || d1 < 1.0e-5_v) ? 1.0e-6_v : 0.01_v * d0 / d1;
+
+      resize(x1, n);
+      resize(xd1, n);
+      for (size_t i = 0; i < n; ++i) {
+         x1[i] = x0[i] + h0 * xd0[i];
+      }
+      system(x1, xd1, t0 + h0);
+
+      value_t d2{};
+      for (size_t i = 0; i < n; ++i)
+      {
+         const value_t sc = scale(i);
+         d2 += ((xd1[i] - xd0[i]) / sc) * ((xd1[i] - xd0[i]) / sc);
+      }
+      d2 = std::sqrt(d2 / n) / h0;
+
+      const value_t d = std::max(d1, d2);
+      const value_t h1 = d <= 1.0e-15_v ? std::max(1.0e-6_v, 1.0e-3_v * h0) : std::pow(0.01_v / d, 1.0_v / static_cast<value_t>(order + 1));
+      return std::min(100.0_v * h0, h1);
+   }
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+
+#include <vector>
+
+namespace asc
+{
+   // Decides when an auto switching integrator changes between DOPRI45 and an implicit integrator (in the manner of LSODA).
+   // Explicit steps feed Hairer's estimate of h * |lambda|: after stiff_steps estimates beyond the stability boundary, without
+   // nonstiff_reset nonstiff ones in between, the system is deemed stiff. Implicit steps feed their size and a norm of their Jacobian,
+   // a bound of |lambda|: once DOPRI45 could have taken nonstiff_steps consecutive steps with nonstiff_ratio to spare, it takes over again.
+   template <class value_t>
+   struct StiffnessSwitchT
+   {
+      // A change of integrator at time t, to the implicit integrator if stiff
+      struct Switch
+      {
+         value_t t{};
+         bool stiff{};
+      };
+
+      value_t stability_boundary = 3.25_v; // h * |lambda| at which DOPRI45 becomes limited by stability (Hairer and Wanner)
+      size_t stiff_steps = 15; // stiff estimates before switching to the implicit integrator
+      size_t nonstiff_reset = 6; // consecutive nonstiff estimates that discard the stiff ones
+      size_t nonstiff_steps = 15; // consecutive implicit steps within the stability boundary before switching back
+      value_t nonstiff_ratio = 5.0_v; // margin to the stability boundary required to switch back, so switches do not oscillate (LSODA's ratio)
+
+      std::vector<Switch> switches; // every switch so far
+
+      bool stiff() const noexcept { return stiff_mode; } // the implicit integrator takes the next step
+
+      // After an explicit step ending at t that estimated h * |lambda|, returns true on a switch to the implicit integrator
+      bool explicit_step(const value_t t, const value_t h_lambda)
+      {
+         if (h_lambda > stability_boundary)
+         {
+            ++n_stiff;
+            n_nonstiff = 0;
+         }
+         else if (++n_nonstiff >= nonstiff_reset) {
+            n_stiff = 0;
+         }
+         return n_stiff >= stiff_steps && change(t, true);
+      }
+
+      // After an implicit step of size h ending at t, whose Jacobian has the given norm, returns true on a switch to DOPRI45
+      bool implicit_step(const value_t t, const value_t h, const value_t jacobian_norm)
+      {
+         if (nonstiff_ratio * h * jacobian_norm <= stability_boundary) {
+            ++n_nonstiff;
+         }
+         else {
+            n_nonstiff = 0;
+         }
+         return n_nonstiff >= nonstiff_steps && change(t, false);
+      }
+
+   private:
+      bool stiff_mode = false;
+      size_t n_stiff{};
+      size_t n_nonstiff{};
+
+      bool change(const value_t t, const bool to_stiff)
+      {
+         stiff_mode = to_stiff;
+         n_stiff = 0;
+         n_nonstiff = 0;
+         switches.emplace_back(Switch{ t, to_stiff });
+         return true;
+      }
+   };
+}
@@ -199,13 +199,9 @@ namespace asc
          return{ size(), *this };
       }
 
-      void emplace_back() noexcept
-      {
-         emplace_back(T());
-      }
-      
-      template <class Arg>
-      void emplace_back(Arg&& x) noexcept
+      // Constructs the element in place, it is never moved as each slice is reserved to the block size
+      template <class... Args>
+      void emplace_back(Args&&... args) noexcept
       {
          auto& s = deq[slice];
          if (s.size() == block)
@@ -213,12 +209,12 @@ namespace asc
             deq.emplace_back();
             auto& v_back = deq.back();
             v_back.reserve(block);
-            v_back.emplace_back(std::forward<Arg>(x));
+            v_back.emplace_back(std::forward<Args>(args)...);
             ++slice;
          }
          else
          {
-            s.emplace_back(std::forward<Arg>(x));
+            s.emplace_back(std::forward<Args>(args)...);
          }
       }
 
@@ -44,7 +44,7 @@ namespace asc
          if (initialized < 3)
          {
             const auto index = 2 - initialized;
-            xd_prev[index].resize(x.size());
+            resize(xd_prev[index], x.size());
             system(x, xd_prev[index], t);
             initializer(system, x, t, dt);
             ++initialized;
@@ -54,8 +54,8 @@ namespace asc
          const size_t n = x.size();
          if (xd0.size() < n)
          {
-            xd0.resize(n);
-            xd_temp.resize(n);
+            resize(xd0, n);
+            resize(xd_temp, n);
          }
 
          x0 = x;
@@ -77,8 +77,8 @@ namespace asc
    private:
       int initialized{};
       init_integrator initializer;
-      state_t x0, xd0, xd_temp;
-      std::array<state_t, 3> xd_prev; //previous time step derivative
+      state_t x0{}, xd0{}, xd_temp{};
+      std::array<state_t, 3> xd_prev{}; //previous time step derivative
 
       static constexpr auto c0 = cx(1.0 / 24.0);
    };
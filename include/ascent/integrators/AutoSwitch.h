@@ -0,0 +1,69 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/StiffnessSwitch.h"
+#include "ascent/integrators/BDF.h"
+#include "ascent/integrators/DOPRI45.h"
+
+// Adaptive integrator for systems that are only stiff at times: DOPRI45 takes the steps while the system is not stiff and an implicit
+// integrator (BDFT or RosenbrockT) while it is, see StiffnessSwitchT. The implicit integrator's Jacobian bounds the stiffness on the way back.
+// Every switch is recorded in switching.switches.
+
+namespace asc
+{
+   template <typename state_t, class implicit_t = BDFT<state_t>>
+   struct AutoSwitchT
+   {
+      using value_t = typename state_t::value_type;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+      {
+         const value_t t0 = t;
+         if (switching.stiff())
+         {
+            implicit(system, x, t, dt, settings);
+
+            if (implicit.matrix.n_jacobians != n_jacobians)
+            {
+               n_jacobians = implicit.matrix.n_jacobians;
+               jacobian_norm = implicit.matrix.norm();
+            }
+            if (switching.implicit_step(t, t - t0, jacobian_norm)) {
+               dopri.reset();
+            }
+         }
+         else
+         {
+            dopri.stiffness_detection = true;
+            dopri(system, x, t, dt, settings);
+
+            if (switching.explicit_step(t, dopri.stiffness())) {
+               implicit.reset();
+            }
+         }
+      }
+
+      DOPRI45T<state_t> dopri;
+      implicit_t implicit;
+      StiffnessSwitchT<value_t> switching;
+
+   private:
+      size_t n_jacobians{};
+      value_t jacobian_norm{};
+   };
+}
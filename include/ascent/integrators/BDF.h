@@ -0,0 +1,341 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/Jacobian.h"
+#include "ascent/algorithms/StepController.h"
+#include "ascent/simd/Kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// Variable order (1 to 5), variable step backward differentiation formulas for stiff systems.
+// The history is a table of backward differences D of the solution at equal steps (Shampine and Reichelt's ode15s, without the NDF modification):
+// a step size change interpolates the table to the new spacing, and the order is chosen after order + 1 equal steps from the
+// error estimates of the neighbouring orders. The implicit equation of a step is solved by simplified Newton iterations with
+// the factorization of I - h / alpha_k * J. The Jacobian is only refreshed when the iterations fail, and the factorization
+// only when the step size or the Jacobian changes.
+// The integrator carries its history between calls, call reset() after changing the state discontinuously.
+
+namespace asc
+{
+   template <typename state_t>
+   struct BDFT
+   {
+      using value_t = typename state_t::value_type;
+      static constexpr size_t max_order = 5;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+      {
+         const size_t n = x.size();
+         if (!started || D[0].size() != n) {
+            start(system, x, t, dt, settings);
+         }
+         else if (dt != h) { // the caller changed the step, e.g. to land on a sample time
+            rescale(dt / h);
+         }
+
+         const value_t tol = newton_tolerance(settings);
+         while (true)
+         {
+            if (h < 10 * std::numeric_limits<value_t>::epsilon() * std::max(std::abs(t), 1.0_v)) {
+               throw std::runtime_error("BDF: step size underflow at t = " + std::to_string(t));
+            }
+
+            const value_t t_new = t + h;
+
+            // predictor and the history part of the corrector equation
+            for (size_t k = 0; k < n; ++k)
+            {
+               value_t p = D[0][k];
+               value_t s{};
+               for (size_t i = 1; i <= order; ++i)
+               {
+                  p += D[i][k];
+                  s += gamma[i] * D[i][k];
+               }
+               y_predict[k] = p;
+               psi[k] = s / gamma[order];
+            }
+
+            const value_t c = h / gamma[order];
+            if (!matrix.factor(c))
+            {
+               rescale(0.5_v); // singular iteration matrix
+               continue;
+            }
+
+            size_t iterations{};
+            if (!solve(system, t_new, c, settings, tol, iterations))
+            {
+               if (matrix.current) {
+                  rescale(0.5_v);
+               }
+               else
+               {
+                  system(y_predict, f, t_new);
+                  matrix.refresh(system, y_predict, f, t_new);
+               }
+               continue;
+            }
+
+            const value_t safety = 0.9_v * (2 * max_newton + 1) / (2 * max_newton + iterations);
+
+            for (size_t k = 0; k < n; ++k) {
+               err[k] = error_const(order) * d[k];
+            }
+            const value_t e = simd::error_norm(err, x, y, settings);
+
+            if (e > 1.0_v)
+            {
+               rescale(std::max(min_factor, safety * std::pow(e, -1.0_v / (order + 1))));
+               continue;
+            }
+
+            // accepted, update the differences
+            for (size_t k = 0; k < n; ++k)
+            {
+               D[order + 2][k] = d[k] - D[order + 1][k];
+               D[order + 1][k] = d[k];
+            }
+            for (size_t i = order + 1; i-- > 0;)
+            {
+               for (size_t k = 0; k < n; ++k) {
+                  D[i][k] += D[i + 1][k];
+               }
+            }
+
+            t = t_new;
+            x = y;
+            matrix.current = false;
+            ++n_equal_steps;
+
+            if (n_equal_steps > order) {
+               select_order(x, e, safety, settings);
+            }
+            dt = h;
+            return;
+         }
+      }
+
+      // Restarts at order one on the next call
+      void reset() noexcept { started = false; }
+
+      size_t current_order() const noexcept { return order; }
+
+      // Change of the order with the largest step factor among order - 1, order and order + 1, ties keep the lower order.
+      // Orders out of range have a factor of zero.
+      static int order_change(const value_t f_m, const value_t f_0, const value_t f_p) noexcept
+      {
+         const value_t best = std::max({ f_m, f_0, f_p });
+         if (best <= value_t{}) return 0;
+         if (f_m == best) return -1;
+         return f_0 == best ? 0 : 1;
+      }
+
+      IterationMatrixT<state_t> matrix;
+      size_t max_newton = 4; // Newton iterations per step
+      value_t min_factor = 0.2_v; // bounds of the step size change
+      value_t max_factor = 10.0_v;
+
+   private:
+      bool started = false;
+      size_t order = 1;
+      size_t n_equal_steps{};
+      value_t h{};
+
+      std::array<state_t, max_order + 3> D{}; // backward differences of the solution scaled by h, D[0] is the solution
+      state_t y_predict{}, psi{}, y{}, d{}, f{}, dy{}, err{};
+
+      // gamma[k] = sum_{j = 1..k} 1 / j, the leading coefficient of the order k formula
+      static constexpr std::array<value_t, max_order + 2> gamma = [] {
+         std::array<value_t, max_order + 2> g{};
+         for (size_t k = 1; k < g.size(); ++k) {
+            g[k] = g[k - 1] + value_t(1) / static_cast<value_t>(k);
+         }
+         return g;
+      }();
+
+      static constexpr value_t error_const(const size_t k) noexcept { return value_t(1) / static_cast<value_t>(k + 1); }
+
+      template <class System>
+      void start(System& system, const state_t& x, const value_t t, value_t& dt, const AdaptiveT<value_t>& settings)
+      {
+         const size_t n = x.size();
+         for (auto& D_i : D)
+         {
+            resize(D_i, n);
+            std::fill(D_i.begin(), D_i.end(), value_t{});
+         }
+         resize(y_predict, n);
+         resize(psi, n);
+         resize(d, n);
+         resize(f, n);
+         resize(dy, n);
+         resize(err, n);
+         y = x;
+
+         system(x, f, t);
+         if (dt <= 0.0_v) {
+            dt = initial_step(system, x, f, y_predict, dy, t, 1, settings);
+         }
+         matrix.refresh(system, x, f, t);
+
+         h = dt;
+         order = 1;
+         n_equal_steps = 0;
+         D[0] = x;
+         for (size_t k = 0; k < n; ++k) {
+            D[1][k] = h * f[k];
+         }
+         started = true;
+      }
+
+      // Simplified Newton iterations for y = y_predict + d with c * f(y) - psi - d = 0
+      template <class System>
+      bool solve(System& system, const value_t t_new, const value_t c, const AdaptiveT<value_t>& settings, const value_t tol, size_t& iterations)
+      {
+         const size_t n = y_predict.size();
+         y = y_predict;
+         std::fill(d.begin(), d.end(), value_t{});
+
+         value_t dy_norm_old{};
+         for (iterations = 1; iterations <= max_newton; ++iterations)
+         {
+            system(y, f, t_new);
+            for (size_t k = 0; k < n; ++k) {
+               dy[k] = c * f[k] - psi[k] - d[k];
+            }
+            matrix.solve(dy);
+
+            const value_t dy_norm = simd::error_norm(dy, y_predict, y_predict, settings);
+            const value_t rate = iterations > 1 ? dy_norm / dy_norm_old : value_t{};
+            if (iterations > 1 && (rate >= 1.0_v || std::pow(rate, static_cast<value_t>(max_newton - iterations + 1)) / (1.0_v - rate) * dy_norm > tol)) {
+               return false; // diverging, or too slow to converge in the remaining iterations
+            }
+
+            for (size_t k = 0; k < n; ++k)
+            {
+               y[k] += dy[k];
+               d[k] += dy[k];
+            }
+
+            if (dy_norm == value_t{} || (iterations > 1 && rate / (1.0_v - rate) * dy_norm < tol)) {
+               return true;
+            }
+            dy_norm_old = dy_norm;
+         }
+         return false;
+      }
+
+      // Chooses the order among order - 1, order and order + 1 with the largest step, from their error estimates
+      void select_order(const state_t& x, const value_t e, const value_t safety, const AdaptiveT<value_t>& settings)
+      {
+         const size_t n = x.size();
+         constexpr value_t inf = std::numeric_limits<value_t>::infinity();
+
+         value_t e_m = inf;
+         if (order > 1)
+         {
+            for (size_t k = 0; k < n; ++k) {
+               err[k] = error_const(order - 1) * D[order][k];
+            }
+            e_m = simd::error_norm(err, x, x, settings);
+         }
+
+         value_t e_p = inf;
+         if (order < max_order)
+         {
+            for (size_t k = 0; k < n; ++k) {
+               err[k] = error_const(order + 1) * D[order + 2][k];
+            }
+            e_p = simd::error_norm(err, x, x, settings);
+         }
+
+         auto step_factor = [](const value_t e_k, const size_t k) {
+            return e_k == inf ? value_t{} : std::pow(std::max(e_k, 1.0e-10_v), -1.0_v / static_cast<value_t>(k + 1));
+         };
+         const value_t f_m = step_factor(e_m, order - 1);
+         const value_t f_0 = step_factor(e, order);
+         const value_t f_p = step_factor(e_p, order + 1);
+
+         const int change = order_change(f_m, f_0, f_p);
+         order += change;
+         rescale(std::min(max_factor, safety * (change < 0 ? f_m : change > 0 ? f_p : f_0)));
+      }
+
+      // Changes the step size by factor, interpolating the differences to the new spacing
+      void rescale(const value_t factor)
+      {
+         if (factor == 1.0_v) {
+            return;
+         }
+
+         // RU = R(factor) * R(1), D[0..order] = RU^T * D[0..order]
+         value_t R[max_order + 1][max_order + 1]{}, U[max_order + 1][max_order + 1]{}, RU[max_order + 1][max_order + 1]{};
+         auto compute_R = [&](const value_t s, value_t (&M)[max_order + 1][max_order + 1]) {
+            for (size_t j = 0; j <= order; ++j) {
+               M[0][j] = 1;
+            }
+            for (size_t i = 1; i <= order; ++i)
+            {
+               M[i][0] = 0;
+               for (size_t j = 1; j <= order; ++j) {
+                  M[i][j] = M[i - 1][j] * (static_cast<value_t>(i) - 1 - s * static_cast<value_t>(j)) / static_cast<value_t>(i);
+               }
+            }
+         };
+         compute_R(factor, R);
+         compute_R(1.0_v, U);
+         for (size_t i = 0; i <= order; ++i)
+         {
+            for (size_t j = 0; j <= order; ++j)
+            {
+               value_t s{};
+               for (size_t k = 0; k <= order; ++k) {
+                  s += R[i][k] * U[k][j];
+               }
+               RU[i][j] = s;
+            }
+         }
+
+         const size_t n = D[0].size();
+         for (size_t k = 0; k < n; ++k)
+         {
+            value_t column[max_order + 1];
+            for (size_t j = 0; j <= order; ++j)
+            {
+               value_t s{};
+               for (size_t i = 0; i <= order; ++i) {
+                  s += RU[i][j] * D[i][k];
+               }
+               column[j] = s;
+            }
+            for (size_t j = 0; j <= order; ++j) {
+               D[j][k] = column[j];
+            }
+         }
+
+         h *= factor;
+         n_equal_steps = 0;
+      }
+   };
+}
@@ -0,0 +1,228 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Ensemble.h"
+#include "ascent/integrators/DOPRI45.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Adaptive Runge Kutta Dormand Prince 45 for ensembles, every member has its own time, step size and accept/reject decision
+
+namespace asc
+{
+   // Members are stored lane interleaved as in Ensemble: component c of member m is x[c * members + m].
+   // A call advances every member that has not reached t_end by one accepted step. Members attempt a step together,
+   // members that rejected are compacted into fewer lanes and retried alone, so accepted members are never recomputed
+   // and no member is throttled to the step size of another.
+   // The system signature is (Batch<const value_t> x, Batch<value_t> xd, const value_t* t), with the time of each lane in t.
+   template <class state_t>
+   struct EnsembleDOPRI45T
+   {
+      using value_t = typename state_t::value_type;
+      using tableau = DOPRI45T<state_t>;
+
+      EnsembleDOPRI45T() = default;
+      EnsembleDOPRI45T(const size_t n_states, const size_t n_members, const value_t dt0) : x(n_states * n_members), t(n_members), dt(n_members, dt0), n_states(n_states), n_members(n_members) {}
+
+      size_t states() const noexcept { return n_states; }
+      size_t members() const noexcept { return n_members; }
+
+      value_t& operator()(const size_t c, const size_t m) noexcept { return x[c * n_members + m]; }
+      const value_t& operator()(const size_t c, const size_t m) const noexcept { return x[c * n_members + m]; }
+
+      // Gathers the state of member m
+      state_t member(const size_t m) const
+      {
+         state_t s(n_states);
+         for (size_t c = 0; c < n_states; ++c) {
+            s[c] = (*this)(c, m);
+         }
+         return s;
+      }
+
+      // Scatters a state into member m
+      void member(const size_t m, const state_t& s)
+      {
+         for (size_t c = 0; c < n_states; ++c) {
+            (*this)(c, m) = s[c];
+         }
+         fsal_computed = false;
+      }
+
+      // Returns the number of members that stepped, zero once every member has reached t_end
+      template <class System>
+      size_t operator()(System&& system, const value_t t_end, const AdaptiveT<value_t>& settings)
+      {
+         const size_t S = n_states;
+         const size_t M = n_members;
+         if (xd.size() != x.size())
+         {
+            xd.resize(x.size());
+            x0.resize(x.size());
+            xs.resize(x.size());
+            for (auto& k : K) {
+               k.resize(x.size());
+            }
+            fsal_computed = false;
+         }
+         if (controllers.size() != M) {
+            controllers.assign(M, controller);
+         }
+
+         if (!fsal_computed) // derivatives at the start of the step for every member
+         {
+            system(Batch<const value_t>{ x.data(), M, S }, Batch<value_t>{ xd.data(), M, S }, t.data());
+            fsal_computed = true;
+         }
+
+         pending.clear();
+         for (size_t m = 0; m < M; ++m)
+         {
+            if (t[m] < t_end) {
+               pending.emplace_back(m);
+            }
+         }
+         const size_t n_stepped = pending.size();
+
+         while (!pending.empty())
+         {
+            const size_t w = pending.size();
+            h.resize(w);
+            t0.resize(w);
+            tl.resize(w);
+            for (size_t l = 0; l < w; ++l)
+            {
+               const size_t m = pending[l];
+               h[l] = std::min(dt[m], t_end - t[m]);
+               t0[l] = t[m];
+            }
+            for (size_t c = 0; c < S; ++c)
+            {
+               for (size_t l = 0; l < w; ++l)
+               {
+                  x0[c * w + l] = x[c * M + pending[l]];
+                  K[0][c * w + l] = xd[c * M + pending[l]];
+               }
+            }
+
+            auto f = [&](const value_t c_t, state_t& k) {
+               for (size_t l = 0; l < w; ++l) {
+                  tl[l] = t0[l] + c_t * h[l];
+               }
+               system(Batch<const value_t>{ xs.data(), w, S, pending.data() }, Batch<value_t>{ k.data(), w, S, pending.data() }, tl.data());
+            };
+
+            stage(w, { 0.2_v }, { &K[0] });
+            f(0.2_v, K[1]);
+            stage(w, { tableau::c10, tableau::c11 }, { &K[0], &K[1] });
+            f(cx(3.0 / 10.0), K[2]);
+            stage(w, { tableau::c20, tableau::c21, tableau::c22 }, { &K[0], &K[1], &K[2] });
+            f(cx(4.0 / 5.0), K[3]);
+            stage(w, { tableau::c30, tableau::c31, tableau::c32, tableau::c33 }, { &K[0], &K[1], &K[2], &K[3] });
+            f(cx(8.0 / 9.0), K[4]);
+            stage(w, { tableau::c40, tableau::c41, tableau::c42, tableau::c43, tableau::c44 }, { &K[0], &K[1], &K[2], &K[3], &K[4] });
+            f(1.0_v, K[5]);
+            stage(w, { tableau::c50, tableau::c52, tableau::c53, tableau::c54, tableau::c55 }, { &K[0], &K[2], &K[3], &K[4], &K[5] });
+            f(1.0_v, K[6]); // first same as last
+
+            // error norm of each lane, the same measure as DOPRI45T with the per component tolerances shared by all members
+            const bool rms = settings.norm == Norm::RMS;
+            e.assign(w, value_t{});
+            for (size_t c = 0; c < S; ++c)
+            {
+               const value_t abs_tol = c < settings.abs_tols.size() ? settings.abs_tols[c] : settings.abs_tol;
+               const value_t rel_tol = c < settings.rel_tols.size() ? settings.rel_tols[c] : settings.rel_tol;
+               for (size_t l = 0; l < w; ++l)
+               {
+                  const size_t i = c * w + l;
+                  const value_t x4 = x0[i] + h[l] * (tableau::e0 * K[0][i] + tableau::e2 * K[2][i] + tableau::e3 * K[3][i] + tableau::e4 * K[4][i] + tableau::e5 * K[5][i] + tableau::e6 * K[6][i]);
+                  const value_t ei = std::abs(x4 - xs[i]) / (abs_tol + rel_tol * std::max(std::abs(x0[i]), std::abs(xs[i])));
+                  e[l] = rms ? e[l] + ei * ei : std::max(e[l], ei);
+               }
+            }
+            if (rms)
+            {
+               for (size_t l = 0; l < w; ++l) {
+                  e[l] = std::sqrt(e[l] / static_cast<value_t>(S));
+               }
+            }
+
+            // accepted lanes are written back, rejected lanes are compacted for the retry
+            size_t n_rejected{};
+            for (size_t l = 0; l < w; ++l)
+            {
+               const size_t m = pending[l];
+               const value_t factor = controllers[m](e[l], 5.0_v, settings.safety_factor);
+               if (e[l] > 1.0_v)
+               {
+                  dt[m] = h[l] * factor;
+                  pending[n_rejected++] = m;
+                  continue;
+               }
+
+               for (size_t c = 0; c < S; ++c)
+               {
+                  x[c * M + m] = xs[c * w + l];
+                  xd[c * M + m] = K[6][c * w + l];
+               }
+               t[m] = t0[l] + h[l];
+               dt[m] = h[l] * factor;
+            }
+            n_rejections += n_rejected;
+            pending.resize(n_rejected); // rejected members are gathered again from their unchanged start states
+         }
+
+         return n_stepped;
+      }
+
+      state_t x; // lane interleaved states
+      state_t t; // time of each member
+      state_t dt; // step size of each member
+      size_t n_rejections{}; // rejected member steps
+      StepControllerT<value_t> controller = StepControllerT<value_t>::PI(); // each member keeps its own copy and error history
+
+   private:
+      size_t n_states{};
+      size_t n_members{};
+      bool fsal_computed = false;
+
+      state_t xd, x0, xs; // derivatives of the members, start and stage states of the lanes
+      state_t K[7]; // stage derivatives of the lanes
+      state_t h, t0, tl, e; // step size, start time, stage time and error norm of each lane
+      std::vector<size_t> pending; // member of each lane
+      std::vector<StepControllerT<value_t>> controllers; // step controller of each member
+
+      // xs = x0 + h * (a[0] * k[0] + ... + a[N-1] * k[N-1]) with the step size of each lane
+      template <size_t N>
+      void stage(const size_t w, const value_t (&a)[N], const state_t* const (&k)[N])
+      {
+         const size_t n = n_states * w;
+         for (size_t i = 0; i < n; i += w)
+         {
+            for (size_t l = 0; l < w; ++l)
+            {
+               value_t s = a[0] * (*k[0])[i + l];
+               for (size_t j = 1; j < N; ++j) {
+                  s += a[j] * (*k[j])[i + l];
+               }
+               xs[i + l] = x0[i + l] + h[l] * s;
+            }
+         }
+      }
+   };
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/simd/Kernels.h"
+
+// Explicit Runge Kutta integrator generated from a Butcher tableau, e.g. ExplicitRKT<tableau::RK38, state_t>.
+// Every stage state is formed in a single fused pass over the previous stages with nonzero weights, zero weights are pruned at compile time.
+
+namespace asc
+{
+   template <class tableau_t, typename state_t>
+   struct ExplicitRKT
+   {
+      using value_t = typename state_t::value_type;
+      static constexpr size_t stages = tableau_t::stages;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, const value_t dt)
+      {
+         const value_t t0 = t;
+
+         const size_t n = x.size();
+         if (xs.size() < n)
+         {
+            resize(xs, n);
+            for (auto& k : xd) {
+               resize(k, n);
+            }
+         }
+
+         x0 = x;
+         system(x0, xd[0], t0);
+         [&]<size_t... i>(std::index_sequence<i...>) {
+            (stage<i + 1>(system, t0, dt), ...);
+         }(std::make_index_sequence<stages - 1>{});
+
+         combine<stages>(x, dt);
+         t = t0 + dt;
+      }
+
+      state_t xd[stages]{}; // stage derivatives
+
+   private:
+      state_t x0{}, xs{};
+
+      template <size_t i, typename System>
+      void stage(System& system, const value_t t0, const value_t dt)
+      {
+         combine<i>(xs, dt);
+         system(xs, xd[i], t0 + cx(tableau_t::c[i]) * dt);
+      }
+
+      // out = x0 + dt * (a[i][0] * xd[0] + ...), i == stages gives the solution weights
+      template <size_t i>
+      void combine(state_t& out, const value_t dt)
+      {
+         tableau::with_nonzero<tableau_t, i>([&]<size_t... j>(std::index_sequence<j...>) {
+            if constexpr (sizeof...(j) == 0) {
+               out = x0;
+            }
+            else {
+               simd::combine(out, x0, dt, { cx(tableau::weight<tableau_t, i, j>)... }, { &xd[j]... });
+            }
+         });
+      }
+   };
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/algorithms/StepController.h"
+#include "ascent/simd/Kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Low storage (Williamson 2N) Runge Kutta, e.g. LowStorageRKT<tableau::CK45, state_t>.
+// A fixed step keeps two scratch states (dx and the derivative), every stage is a single streaming pass over x, dx and the derivative.
+// The adaptive step of a scheme with error weights adds the start state and the error register.
+
+namespace asc
+{
+   template <class scheme_t, typename state_t>
+   struct LowStorageRKT
+   {
+      using value_t = typename state_t::value_type;
+      static constexpr size_t stages = scheme_t::stages;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, const value_t dt)
+      {
+         step(system, x, t, dt, nullptr);
+      }
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings) requires requires { scheme_t::E; }
+      {
+         const value_t t0 = t;
+         const size_t n = x.size();
+         resize(err, n);
+
+         if (dt <= 0.0_v) // estimate the first step
+         {
+            resize(xd, n);
+            system(x, xd, t);
+            dt = initial_step(system, x, xd, x0, dx, t, scheme_t::embedded_order + 1, settings);
+         }
+
+         constexpr value_t order = static_cast<value_t>(scheme_t::embedded_order + 1); // the error estimate is O(dt^order)
+
+         while (true)
+         {
+            x0 = x;
+            step(system, x, t, dt, &err);
+
+            const value_t e = simd::error_norm(err, x0, x, settings);
+
+            const value_t factor = controller(e, order, settings.safety_factor);
+            if (e > 1.0_v)
+            {
+               dt *= factor;
+               t = t0;
+               x = x0;
+               continue;
+            }
+
+            dt *= factor;
+            return;
+         }
+      }
+
+      state_t xd{};
+      StepControllerT<value_t> controller = StepControllerT<value_t>::PI(); // used by adaptive steps, dt <= 0 estimates the first step
+
+   private:
+      state_t dx{}, x0{}, err{};
+
+      template <typename System>
+      void step(System& system, state_t& x, value_t& t, const value_t dt, state_t* e)
+      {
+         const value_t t0 = t;
+
+         const size_t n = x.size();
+         if (dx.size() < n)
+         {
+            resize(dx, n);
+            resize(xd, n);
+         }
+
+         [&]<size_t... i>(std::index_sequence<i...>) {
+            ((system(x, xd, t0 + cx(scheme_t::C[i]) * dt), stage<i>(x, dt, e)), ...);
+         }(std::make_index_sequence<stages>{});
+
+         t = t0 + dt;
+      }
+
+      template <size_t i>
+      void stage(state_t& x, const value_t dt, state_t* e)
+      {
+         value_t e_i{};
+         if constexpr (requires { scheme_t::E; }) {
+            e_i = cx(scheme_t::E[i]);
+         }
+         simd::low_storage<i == 0>(x, dx, xd, cx(scheme_t::A[i]), cx(scheme_t::B[i]), dt, e, e_i);
+      }
+   };
+}
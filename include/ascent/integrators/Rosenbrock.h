@@ -0,0 +1,235 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/algorithms/Jacobian.h"
+#include "ascent/algorithms/StepController.h"
+#include "ascent/simd/Kernels.h"
+
+#include <cmath>
+#include <limits>
+
+// Adaptive Rosenbrock(-W) integrator for stiff systems, e.g. RosenbrockT<tableau::ROS34PW2, state_t>.
+// Every stage is one linear solve with the factorization of I - gamma * h * J, there is no Newton iteration.
+// The stages are solved in Hairer and Wanner's transformed variables u_i = sum Gamma_ij k_j, which avoids Jacobian products.
+// With a W-method the Jacobian is kept across steps and refreshed after a rejected step or every max_jacobian_age steps,
+// and the step size is held when the controller would only grow it slightly, so the factorization is reused as well.
+
+namespace asc
+{
+   template <class scheme_t, typename state_t>
+   struct RosenbrockT
+   {
+      using value_t = typename state_t::value_type;
+      static constexpr size_t stages = scheme_t::stages;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+      {
+         const value_t t0 = t;
+         const size_t n = x.size();
+         resize(xd, n);
+         resize(fs, n);
+         resize(ft, n);
+         resize(err, n);
+         for (auto& u_i : u) {
+            resize(u_i, n);
+         }
+
+         x0 = x;
+         system(x0, xd, t0);
+
+         if (dt <= 0.0_v) { // estimate the first step
+            dt = initial_step(system, x0, xd, xs, fs, t0, scheme_t::order, settings);
+         }
+
+         if (!autonomous) // df/dt by a forward difference
+         {
+            const value_t h_t = JacobianT<state_t>::delta(t0);
+            system(x0, fs, t0 + h_t);
+            for (size_t i = 0; i < n; ++i) {
+               ft[i] = (fs[i] - xd[i]) / h_t;
+            }
+         }
+
+         bool rejected = false;
+         while (true)
+         {
+            if (matrix.empty() || jacobian_age >= max_jacobian_age || (rejected && !matrix.current))
+            {
+               matrix.refresh(system, x0, xd, t0);
+               jacobian_age = 0;
+            }
+
+            const value_t c = cx(scheme_t::gamma) * dt;
+            if (!matrix.factor(c))
+            {
+               dt *= 0.5_v; // singular iteration matrix
+               continue;
+            }
+
+            [&]<size_t... i>(std::index_sequence<i...>) {
+               (stage<i>(system, t0, dt, c), ...);
+            }(std::make_index_sequence<stages>{});
+
+            for (size_t k = 0; k < n; ++k)
+            {
+               value_t x_k = x0[k];
+               value_t e_k{};
+               for (size_t i = 0; i < stages; ++i)
+               {
+                  x_k += coefficients.m[i] * u[i][k];
+                  e_k += coefficients.e[i] * u[i][k];
+               }
+               x[k] = x_k;
+               err[k] = e_k;
+            }
+
+            const value_t e = simd::error_norm(err, x0, x, settings);
+            const value_t factor = controller(e, static_cast<value_t>(scheme_t::embedded_order + 1), settings.safety_factor);
+
+            if (e > 1.0_v)
+            {
+               held = 1.0_v;
+               dt *= factor;
+               x = x0;
+               rejected = true;
+               continue;
+            }
+
+            t = t0 + dt;
+            held *= factor; // small increases are accumulated while dt is kept, so the factorization is reused
+            if (held < 1.0_v || held > hold_factor)
+            {
+               dt *= held;
+               held = 1.0_v;
+            }
+            matrix.current = false;
+            ++jacobian_age;
+            return;
+         }
+      }
+
+      // Refreshes the Jacobian on the next call, e.g. after the state changed discontinuously
+      void reset() noexcept
+      {
+         jacobian_age = max_jacobian_age;
+         held = 1.0_v;
+      }
+
+      IterationMatrixT<state_t> matrix;
+      StepControllerT<value_t> controller = StepControllerT<value_t>::PI();
+      bool autonomous = false; // skips the time derivative of the system, saving an evaluation per step
+      size_t max_jacobian_age = 20; // accepted steps a Jacobian is kept for
+      value_t hold_factor = 1.2_v; // accumulated growth below this keeps the step size
+
+   private:
+      // Stage coefficients in the transformed variables
+      struct Coefficients
+      {
+         double a[stages][stages]{}; // alpha * Gamma^-1
+         double C[stages][stages]{}; // diag(1 / gamma) - Gamma^-1
+         double m[stages]{}; // b * Gamma^-1
+         double e[stages]{}; // (b - bhat) * Gamma^-1
+         double alpha[stages]{}; // stage times
+         double gamma[stages]{}; // row sums of Gamma
+      };
+
+      static constexpr Coefficients coefficients = [] {
+         double G[stages][stages]{};
+         for (size_t i = 0; i < stages; ++i)
+         {
+            for (size_t j = 0; j < i; ++j) {
+               G[i][j] = scheme_t::g[i][j];
+            }
+            G[i][i] = scheme_t::gamma;
+         }
+
+         double inv[stages][stages]{}; // Gamma^-1 by forward substitution
+         for (size_t j = 0; j < stages; ++j)
+         {
+            inv[j][j] = 1.0 / G[j][j];
+            for (size_t i = j + 1; i < stages; ++i)
+            {
+               double s{};
+               for (size_t k = j; k < i; ++k) {
+                  s += G[i][k] * inv[k][j];
+               }
+               inv[i][j] = -s / G[i][i];
+            }
+         }
+
+         Coefficients r{};
+         for (size_t i = 0; i < stages; ++i)
+         {
+            for (size_t j = 0; j < stages; ++j)
+            {
+               for (size_t k = 0; k < stages; ++k) {
+                  r.a[i][j] += scheme_t::alpha[i][k] * inv[k][j];
+               }
+               r.C[i][j] = (i == j ? 1.0 / scheme_t::gamma : 0.0) - inv[i][j];
+               r.m[j] += scheme_t::b[i] * inv[i][j];
+               r.e[j] += (scheme_t::b[i] - scheme_t::bhat[i]) * inv[i][j];
+               r.alpha[i] += scheme_t::alpha[i][j];
+               r.gamma[i] += G[i][j];
+            }
+         }
+         return r;
+      }();
+
+      state_t x0{}, xd{}, xs{}, fs{}, ft{}, err{};
+      state_t u[stages]{};
+      size_t jacobian_age{};
+      value_t held = 1.0_v; // growth held back since dt last changed
+
+      // (I - c * J) u_i = c * (f(x0 + sum a_ij u_j) + sum C_ij / dt * u_j + gamma_i * dt * df/dt), c = gamma * dt
+      template <size_t i, class System>
+      void stage(System& system, const value_t t0, const value_t dt, const value_t c)
+      {
+         const size_t n = x0.size();
+         const state_t* f = &xd; // the first stage is evaluated at the start of the step
+         if constexpr (i > 0)
+         {
+            xs = x0;
+            for (size_t j = 0; j < i; ++j)
+            {
+               const value_t a_ij = static_cast<value_t>(coefficients.a[i][j]);
+               if (a_ij != value_t{})
+               {
+                  for (size_t k = 0; k < n; ++k) {
+                     xs[k] += a_ij * u[j][k];
+                  }
+               }
+            }
+            system(xs, fs, t0 + static_cast<value_t>(coefficients.alpha[i]) * dt);
+            f = &fs;
+         }
+
+         const value_t g_t = autonomous ? value_t{} : static_cast<value_t>(coefficients.gamma[i]) * dt;
+         auto& u_i = u[i];
+         for (size_t k = 0; k < n; ++k)
+         {
+            value_t s = (*f)[k] + g_t * ft[k];
+            for (size_t j = 0; j < i; ++j) {
+               s += static_cast<value_t>(coefficients.C[i][j]) / dt * u[j][k];
+            }
+            u_i[k] = c * s;
+         }
+         matrix.solve(u_i);
+      }
+   };
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/algorithms/Jacobian.h"
+#include "ascent/algorithms/StepController.h"
+#include "ascent/simd/Kernels.h"
+
+#include <cmath>
+
+// Adaptive singly diagonally implicit Runge Kutta integrator for stiff systems, e.g. SDIRKT<tableau::SDIRK4, state_t>.
+// Every stage is solved by simplified Newton iterations with the factorization of I - gamma * h * J, shared by all stages.
+// The Jacobian is refreshed only when the Newton iterations fail to converge, and the step size is held when the controller
+// would only grow it slightly, so the factorization is reused across steps. The error estimate is filtered through the
+// factorization (Hairer and Wanner) so that stiff components do not inflate it.
+
+namespace asc
+{
+   template <class scheme_t, typename state_t>
+   struct SDIRKT
+   {
+      using value_t = typename state_t::value_type;
+      static constexpr size_t stages = scheme_t::stages;
+
+      template <typename System>
+      void operator()(System&& system, state_t& x, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+      {
+         const value_t t0 = t;
+         const size_t n = x.size();
+         resize(xd, n);
+         resize(base, n);
+         resize(dy, n);
+         resize(err, n);
+         for (auto& F_i : F) {
+            resize(F_i, n);
+         }
+
+         x0 = x;
+         bool evaluated = false; // xd holds the derivative at the start of the step
+         auto evaluate = [&] {
+            if (!evaluated)
+            {
+               system(x0, xd, t0);
+               evaluated = true;
+            }
+         };
+
+         if (dt <= 0.0_v) // estimate the first step
+         {
+            evaluate();
+            dt = initial_step(system, x0, xd, base, dy, t0, scheme_t::order, settings);
+         }
+
+         const value_t tol = newton_tolerance(settings);
+         bool refresh = matrix.empty();
+         while (true)
+         {
+            if (refresh)
+            {
+               evaluate();
+               matrix.refresh(system, x0, xd, t0);
+               refresh = false;
+            }
+
+            const value_t c = cx(scheme_t::gamma) * dt;
+            if (!matrix.factor(c))
+            {
+               dt *= 0.5_v; // singular iteration matrix
+               continue;
+            }
+
+            bool converged = true;
+            x = x0;
+            for (size_t i = 0; i < stages && converged; ++i) {
+               converged = solve_stage(system, i, x, t0, dt, c, settings, tol);
+            }
+
+            if (!converged)
+            {
+               if (matrix.current) {
+                  dt *= 0.5_v;
+               }
+               else {
+                  refresh = true;
+               }
+               x = x0;
+               continue;
+            }
+
+            for (size_t k = 0; k < n; ++k)
+            {
+               value_t x_k = x0[k];
+               value_t e_k{};
+               for (size_t i = 0; i < stages; ++i)
+               {
+                  x_k += dt * cx(scheme_t::b[i]) * F[i][k];
+                  e_k += dt * cx(scheme_t::b[i] - scheme_t::bhat[i]) * F[i][k];
+               }
+               x[k] = x_k;
+               err[k] = e_k;
+            }
+            matrix.solve(err);
+
+            const value_t e = simd::error_norm(err, x0, x, settings);
+            const value_t factor = controller(e, static_cast<value_t>(scheme_t::embedded_order + 1), settings.safety_factor);
+
+            if (e > 1.0_v)
+            {
+               held = 1.0_v;
+               dt *= factor;
+               x = x0;
+               continue;
+            }
+
+            t = t0 + dt;
+            held *= factor; // small increases are accumulated while dt is kept, so the factorization is reused
+            if (held < 1.0_v || held > hold_factor)
+            {
+               dt *= held;
+               held = 1.0_v;
+            }
+            matrix.current = false;
+            return;
+         }
+      }
+
+      IterationMatrixT<state_t> matrix;
+      StepControllerT<value_t> controller = StepControllerT<value_t>::PI();
+      size_t max_newton = 7; // Newton iterations per stage
+      value_t hold_factor = 1.2_v; // accumulated growth below this keeps the step size
+
+   private:
+      state_t x0{}, xd{}, base{}, dy{}, err{};
+      value_t held = 1.0_v; // growth held back since dt last changed
+      state_t F[stages]{}; // stage derivatives
+
+      // Solves Y = base + c * f(Y) for stage i, base = x0 + dt * sum a_ij F_j. Y starts from the previous stage value held in y.
+      template <class System>
+      bool solve_stage(System& system, const size_t i, state_t& y, const value_t t0, const value_t dt, const value_t c, const AdaptiveT<value_t>& settings, const value_t tol)
+      {
+         const size_t n = x0.size();
+         for (size_t k = 0; k < n; ++k)
+         {
+            value_t s = x0[k];
+            for (size_t j = 0; j < i; ++j) {
+               s += dt * cx(scheme_t::a[i][j]) * F[j][k];
+            }
+            base[k] = s;
+         }
+
+         const value_t t_i = t0 + cx(scheme_t::c[i]) * dt;
+         value_t dy_norm_old{};
+         for (size_t iteration = 0; iteration < max_newton; ++iteration)
+         {
+            system(y, F[i], t_i);
+            for (size_t k = 0; k < n; ++k) {
+               dy[k] = base[k] + c * F[i][k] - y[k];
+            }
+            matrix.solve(dy);
+            for (size_t k = 0; k < n; ++k) {
+               y[k] += dy[k];
+            }
+
+            const value_t dy_norm = simd::error_norm(dy, x0, y, settings);
+            const value_t rate = iteration > 0 ? dy_norm / dy_norm_old : value_t{};
+            if (iteration > 0 && (rate >= 1.0_v || std::pow(rate, static_cast<value_t>(max_newton - iteration)) / (1.0_v - rate) * dy_norm > tol)) {
+               return false; // diverging, or too slow to converge in the remaining iterations
+            }
+            if (dy_norm == value_t{} || (iteration > 0 && rate / (1.0_v - rate) * dy_norm < tol))
+            {
+               for (size_t k = 0; k < n; ++k) {
+                  F[i][k] = (y[k] - base[k]) / c; // satisfies the stage equation exactly, rather than amplifying the Newton error through a stiff f
+               }
+               return true;
+            }
+            dy_norm_old = dy_norm;
+         }
+         return false;
+      }
+   };
+}
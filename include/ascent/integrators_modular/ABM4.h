@@ -24,36 +24,38 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct ABM4prop : public Propagator<value_t>
+      struct ABM4prop : public BatchPropagator<ABM4prop<value_t>, value_t>
       {
-         void operator()(State &state, const value_t dt) override
+         ABM4prop() : BatchPropagator<ABM4prop<value_t>, value_t>(6) {}
+
+         void batch(const StateSpan<value_t> &s, const size_t pass, const value_t dt)
          {
-            auto &x = *state.x;
-            auto &xd = *state.xd;
-            if (state.memory.size() < 6) {
-               state.memory.resize(6);
-            }
-            auto &x0 = state.memory[0];
-            auto &xd0 = state.memory[1];
-            auto &xp = state.memory[2]; // Can be used for error estimates
-            auto &xd_1 = state.memory[3];
-            auto &xd_2 = state.memory[4];
-            auto &xd_3 = state.memory[5];
-
-            switch (Propagator<value_t>::pass)
+            const size_t n = s.size();
+            auto *x0 = s.column(0);
+            auto *xd0 = s.column(1);
+            auto *xp = s.column(2); // Can be used for error estimates
+            auto *xd_1 = s.column(3);
+            auto *xd_2 = s.column(4);
+            auto *xd_3 = s.column(5);
+
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + c0 * dt * (55.0 * xd0 - 59.0 * xd_1 + 37.0 * xd_2 - 9.0 * xd_3);
-               xp = x;
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + c0 * dt * (55.0 * xd0[i] - 59.0 * xd_1[i] + 37.0 * xd_2[i] - 9.0 * xd_3[i]);
+                  xp[i] = *s.x[i];
+               }
                break;
             case 1:
-               //x = x0 + c0 * dt * (9.0 * xd + 19.0 * xd0 - 5.0 * xd_1 + xd_2);
-               x = x0 + c1 * dt * (251.0 * xd + 646.0 * xd0 - 264.0 * xd_1 + 106.0 * xd_2 - 19.0 * xd_3);
-               xd_3 = xd_2;
-               xd_2 = xd_1;
-               xd_1 = xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  //x = x0 + c0 * dt * (9.0 * xd + 19.0 * xd0 - 5.0 * xd_1 + xd_2);
+                  *s.x[i] = x0[i] + c1 * dt * (251.0 * *s.xd[i] + 646.0 * xd0[i] - 264.0 * xd_1[i] + 106.0 * xd_2[i] - 19.0 * xd_3[i]);
+                  xd_3[i] = xd_2[i];
+                  xd_2[i] = xd_1[i];
+                  xd_1[i] = xd0[i];
+               }
                break;
             }
          }
@@ -97,28 +99,13 @@ namespace asc
                   initializer.run_first = run_first;
                }
 
+               auto &arena = propagator.arena;
+
                // Record full step state history
                if (initialized == 0) {
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block.second->states)
-                        {
-                           state.hist_len = 3;
-                        }
-                     }
-                  }
-                  else
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block->states)
-                        {
-                           state.hist_len = 3;
-                        }
-                     }
-                  }
+                  arena.sync(blocks);
+                  arena.history(3);
+                  initializer.propagator.history = &arena;
                }
 
                // Run initializer integrator
@@ -126,37 +113,16 @@ namespace asc
                ++initialized;
 
                if (initialized == 3) {
-                  // calc_phi for past steps and store in the states memory
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block.second->states)
-                        {
-                           if (state.memory.size() < 6) {
-                              state.memory.resize(6);
-                           }
-                           for (size_t k = 0; k < 3; ++k) {
-                              state.memory[5 - k] = state.xd0_hist[k];
-                              state.hist_len = 0; // We dont need to track the history anymore
-                           }
-                        }
-                     }
-                  }
-                  else
+                  initializer.propagator.history = nullptr; // We dont need to track the history anymore
+
+                  // copy the startup derivative history into the stage memory
+                  const size_t n = arena.size();
+                  for (size_t k = 0; k < 3; ++k)
                   {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block->states)
-                        {
-                           if (state.memory.size() < 6) {
-                              state.memory.resize(6);
-                           }
-                           for (size_t k = 0; k < 3; ++k) {
-                              state.memory[5 - k] = state.xd0_hist[k];
-                              state.hist_len = 0; // We dont need to track the history anymore
-                           }
-                        }
+                     const auto *xd_k = arena.xd_history(k);
+                     auto *xd = arena.column(5 - k);
+                     for (size_t i = 0; i < n; ++i) {
+                        xd[i] = xd_k[i];
                      }
                   }
                }
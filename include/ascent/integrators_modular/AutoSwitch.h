@@ -0,0 +1,75 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/algorithms/StiffnessSwitch.h"
+#include "ascent/integrators_modular/DOPRI45.h"
+#include "ascent/integrators_modular/TRBDF2.h"
+#include "ascent/timing/Timing.h"
+#include "ascent/Utility.h"
+
+// Adaptive integrator for blocks that are only stiff at times: DOPRI45 takes the steps while they are not stiff and TRBDF2 while they are,
+// see StiffnessSwitchT. TRBDF2's preconditioner Jacobian bounds the stiffness on the way back, so it must keep precondition set.
+// Every switch is recorded in switching.switches.
+
+namespace asc
+{
+   namespace modular
+   {
+      template <class value_t>
+      struct AutoSwitch : AdaptiveIntegrator
+      {
+         DOPRI45<value_t> dopri;
+         TRBDF2<value_t> implicit;
+         StiffnessSwitchT<value_t> switching;
+
+         asc::Timing<double>* run_first{};
+
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+         {
+            const value_t t0 = t;
+            if (switching.stiff())
+            {
+               implicit.run_first = run_first;
+               implicit(blocks, t, dt, settings);
+
+               if (implicit.n_jacobians != n_jacobians)
+               {
+                  n_jacobians = implicit.n_jacobians;
+                  jacobian_norm = implicit.jacobian_norm();
+               }
+               if (switching.implicit_step(t, t - t0, jacobian_norm)) {
+                  dopri.fsal_computed = false;
+               }
+            }
+            else
+            {
+               dopri.run_first = run_first;
+               dopri.stiffness_detection = true;
+               dopri(blocks, t, dt, settings);
+
+               if (switching.explicit_step(t, dopri.stiffness())) {
+                  implicit.reset();
+               }
+            }
+         }
+
+      private:
+         size_t n_jacobians{};
+         value_t jacobian_norm{};
+      };
+   }
+}
@@ -24,57 +24,75 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct DOPRI45prop : public Propagator<value_t>
+      struct DOPRI45prop : public BatchPropagator<DOPRI45prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         DOPRI45prop() : BatchPropagator<DOPRI45prop<value_t>, value_t>(7) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
             const auto dt_5 = 0.2_v * dt;
 
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 7)
-            {
-               state.memory.resize(7);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd_temp = state.memory[2];  // xd_temp is used for xd1 and xd5
-            auto& xd2 = state.memory[3];
-            auto& xd3 = state.memory[4];
-            auto& xd4 = state.memory[5];
-            auto& xd6 = state.memory[6];
-
-            switch (Propagator<value_t>::pass)
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd_temp = s.column(2);  // xd_temp is used for xd1 and xd5
+            auto* xd2 = s.column(3);
+            auto* xd3 = s.column(4);
+            auto* xd4 = s.column(5);
+
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + dt_5 * xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt_5 * xd0[i];
+               }
                break;
             case 1:
-               xd_temp = xd;
-               x = x0 + dt * (c10 * xd0 + c11 * xd_temp);
+               for (size_t i = 0; i < n; ++i) {
+                  xd_temp[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * (c10 * xd0[i] + c11 * xd_temp[i]);
+               }
                break;
             case 2:
-               xd2 = xd;
-               x = x0 + dt * (c20 * xd0 + c21 * xd_temp + c22 * xd2);
+               for (size_t i = 0; i < n; ++i) {
+                  xd2[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * (c20 * xd0[i] + c21 * xd_temp[i] + c22 * xd2[i]);
+               }
                break;
             case 3:
-               xd3 = xd;
-               x = x0 + dt * (c30 * xd0 + c31 * xd_temp + c32 * xd2 + c33 * xd3);
+               for (size_t i = 0; i < n; ++i) {
+                  xd3[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * (c30 * xd0[i] + c31 * xd_temp[i] + c32 * xd2[i] + c33 * xd3[i]);
+               }
+               break;
             case 4:
-               xd4 = xd;
-               x = x0 + dt * (c40 * xd0 + c41 * xd_temp + c42 * xd2 + c43 * xd3 + c44 * xd4);
+               for (size_t i = 0; i < n; ++i) {
+                  xd4[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * (c40 * xd0[i] + c41 * xd_temp[i] + c42 * xd2[i] + c43 * xd3[i] + c44 * xd4[i]);
+               }
                break;
             case 5:
-               xd_temp = xd;
-               x = x0 + dt * (c50 * xd0 + c52 * xd2 + c53 * xd3 + c54 * xd4 + c55 * xd_temp);
+               if (stiffness_detection)
+               {
+                  auto* x_stiff = s.column(9);
+                  for (size_t i = 0; i < n; ++i) {
+                     x_stiff[i] = *s.x[i];
+                  }
+               }
+               for (size_t i = 0; i < n; ++i) {
+                  xd_temp[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * (c50 * xd0[i] + c52 * xd2[i] + c53 * xd3[i] + c54 * xd4[i] + c55 * xd_temp[i]);
+               }
                break;
             default:
                break;
             }
          }
 
+         bool stiffness_detection = false; // keeps the state of the last stage in column 9
+
       private:
          static constexpr auto c10 = cx(3.0 / 40.0);
          static constexpr auto c11 = cx(9.0 / 40.0);
@@ -145,41 +163,23 @@ namespace asc
 
          asc::Timing<double>* run_first{};
 
+         StepControllerT<value_t> controller = StepControllerT<value_t>::PI(); // used by adaptive steps, dt <= 0 estimates the first step
+
          template <class modules_t>
          void system(modules_t& blocks, value_t& t, const value_t dt)
          {
+            auto& arena = propagator.arena;
+
             if (!fsal_computed) // if an adaptive stepper hasn't computed the first same as last state, we must compute the step here
             {
                update(blocks);
                apply(blocks);
 
-               auto solve = [&](auto& state)
-               {
-                  auto& xd = *state.xd;
-                  if (state.memory.size() < 7)
-                  {
-                     state.memory.resize(7);
-                  }
-                  auto& xd0 = state.memory[1];
-                  xd0 = xd;
-               };
-
-               for (auto& block : blocks)
-               {
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto& state : block.second->states)
-                     {
-                        solve(state);
-                     }
-                  }
-                  else
-                  {
-                     for (auto& state : block->states)
-                     {
-                        solve(state);
-                     }
-                  }
+               arena.sync(blocks);
+               const size_t n = arena.size();
+               auto* xd0 = arena.column(1);
+               for (size_t i = 0; i < n; ++i) {
+                  xd0[i] = *arena.xd[i];
                }
                fsal_computed = false;
             }
@@ -206,11 +206,25 @@ namespace asc
          template <class modules_t>
          void operator()(modules_t& blocks, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
          {
-            const value_t abs_tol = settings.abs_tol;
-            const value_t rel_tol = settings.rel_tol;
-            const value_t safety_factor = settings.safety_factor;
-
             const value_t t0 = t;
+
+            if (dt <= 0.0_v) // estimate the first step
+            {
+               dt = initial_step(blocks, t, 5, settings);
+
+               if (run_first) {
+                  run_first->base_time_step(dt);
+               }
+            }
+
+            auto& arena = propagator.arena;
+            if (dense_output && arena.columns() < 9) {
+               arena.columns(9); // the first stage and the dense output coefficient
+            }
+            propagator.stiffness_detection = stiffness_detection;
+            if (stiffness_detection && arena.columns() < 10) {
+               arena.columns(10); // the state of the last stage
+            }
          
          start_adaptive:
             system(blocks, t, dt);
@@ -218,84 +232,42 @@ namespace asc
             // xd6 is xd0, because first same as last (FSAL)
             update(blocks);
             apply(blocks);
-            for (auto& block : blocks)
-            {
-               auto solve = [&](auto& state)
-               {
-                  auto& xd = *state.xd;
-                  if (state.memory.size() < 7)
-                  {
-                     state.memory.resize(7);
-                  }
-                  auto& xd6 = state.memory[6];
-                  xd6 = xd;
-               };
 
-               if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-               {
-                  for (auto& state : block.second->states)
-                  {
-                     solve(state);
-                  }
-               }
-               else
-               {
-                  for (auto& state : block->states)
-                  {
-                     solve(state);
-                  }
-               }
+            const size_t n = arena.size();
+            auto* x0 = arena.column(0);
+            auto* xd0 = arena.column(1);
+            auto* xd_temp = arena.column(2); // xd_temp is used for xd1 and xd5
+            auto* xd2 = arena.column(3);
+            auto* xd3 = arena.column(4);
+            auto* xd4 = arena.column(5);
+            auto* xd6 = arena.column(6);
+
+            for (size_t i = 0; i < n; ++i) {
+               xd6[i] = *arena.xd[i];
             }
 
-            value_t e_max{};
-            for (auto& block : blocks)
+            if (dense_output)
             {
-               auto solve = [&](auto& state)
+               auto* xd_first = arena.column(7);
+               auto* xd_dense = arena.column(8);
+               for (size_t i = 0; i < n; ++i)
                {
-                  auto& x = *state.x;
-                  auto& xd = *state.xd;
-                  if (state.memory.size() < 7)
-                  {
-                     state.memory.resize(7);
-                  }
-                  auto& x0 = state.memory[0];
-                  auto& xd0 = state.memory[1];
-                  auto& xd_temp = state.memory[2];  // xd_temp is used for xd1 and xd5
-                  auto& xd2 = state.memory[3];
-                  auto& xd3 = state.memory[4];
-                  auto& xd4 = state.memory[5];
-                  auto& xd6 = state.memory[6];
-
-                  // overwrite xd2 as the error estimate, this saves memory
-                  xd2 = abs(x0 + dt * (e0 * xd0 + e2 * xd2 + e3 * xd3 + e4 * xd4 + e5 * xd_temp + e6 * xd6) - x); // absolute error estimate (x4th - x5th)
-
-                  value_t e = xd2 / (abs_tol + rel_tol * (abs(x0) + 0.01 * abs(xd0)));
-
-                  if (e > e_max)
-                  {
-                     e_max = e;
-                  }
-               };
-
-               if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-               {
-                  for (auto& state : block.second->states)
-                  {
-                     solve(state);
-                  }
-               }
-               else
-               {
-                  for (auto& state : block->states)
-                  {
-                     solve(state);
-                  }
+                  xd_first[i] = xd0[i];
+                  xd_dense[i] = x0[i] + dt * (d0 * xd0[i] + d2 * xd2[i] + d3 * xd3[i] + d4 * xd4[i] + d5 * xd_temp[i] + d6 * xd6[i]); // before xd2 is overwritten
                }
             }
 
-            if (e_max > 1.0)
+            const value_t e = error_norm(blocks, propagator, settings, [&](const size_t i) {
+               return std::abs(x0[i] + dt * (e0 * xd0[i] + e2 * xd2[i] + e3 * xd3[i] + e4 * xd4[i] + e5 * xd_temp[i] + e6 * xd6[i]) - *arena.x[i]); // absolute error estimate (x4th - x5th)
+            }, [&](const size_t i) {
+               return std::max(std::abs(x0[i]), std::abs(*arena.x[i]));
+            });
+
+            const value_t factor = controller(e, 5.0_v, settings.safety_factor); // the error estimate is O(dt^5)
+
+            if (e > 1.0_v)
             {
-               dt *= std::max(0.9_v * pow(e_max, -cx(1.0 / 3.0)), 0.2_v);
+               dt *= factor;
 
                if (run_first) {
                   run_first->base_time_step(dt);
@@ -303,76 +275,106 @@ namespace asc
 
                t = t0;
 
-               for (auto& block : blocks)
-               {
-                  auto solve = [&](auto& state)
-                  {
-                     *state.x = state.memory[0];
-                  };
-
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto& state : block.second->states)
-                     {
-                        solve(state);
-                     }
-                  }
-                  else
-                  {
-                     for (auto& state : block->states)
-                     {
-                        solve(state);
-                     }
-                  }
+               for (size_t i = 0; i < n; ++i) {
+                  *arena.x[i] = x0[i];
                }
 
                goto start_adaptive; // recompute the solution recursively
             }
 
-            if (e_max < 0.5_v)
-            {
-               e_max = std::max(3.2e-4_v, e_max); // 3.2e-4 = pow(5, -5)
-               dt *= 0.9_v * pow(e_max, -0.2_v);
+            t_dense = t0;
+            dt_dense = dt;
 
-               if (run_first) {
-                  run_first->base_time_step(dt);
-               }
-            }
-
-            for (auto& block : blocks)
+            if (stiffness_detection) // Hairer's test, the last two stages are evaluated at x_stiff and the states at the same time
             {
-               auto solve = [&](auto& state)
-               {
-                  auto& xd = *state.xd;
-                  if (state.memory.size() < 7)
-                  {
-                     state.memory.resize(7);
-                  }
-                  auto& xd0 = state.memory[1];
-                  auto& xd6 = state.memory[6];
-                  xd0 = xd6;
-               };
-
-               if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-               {
-                  for (auto& state : block.second->states)
-                  {
-                     solve(state);
+               auto* x_stiff = arena.column(9);
+               const value_t df2 = sum_rows(propagator, [&](const size_t begin, const size_t end) {
+                  value_t sum{};
+                  for (size_t i = begin; i < end; ++i) {
+                     sum += (xd6[i] - xd_temp[i]) * (xd6[i] - xd_temp[i]);
                   }
-               }
-               else
-               {
-                  for (auto& state : block->states)
-                  {
-                     solve(state);
+                  return sum;
+               });
+               const value_t dx2 = sum_rows(propagator, [&](const size_t begin, const size_t end) {
+                  value_t sum{};
+                  for (size_t i = begin; i < end; ++i) {
+                     sum += (*arena.x[i] - x_stiff[i]) * (*arena.x[i] - x_stiff[i]);
                   }
-               }
+                  return sum;
+               });
+               h_lambda = dx2 > 0.0_v ? dt * std::sqrt(df2 / dx2) : 0.0_v;
+            }
+
+            dt *= factor;
+
+            if (run_first) {
+               run_first->base_time_step(dt);
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+               xd0[i] = xd6[i];
             }
             
             fsal_computed = true;
          }
 
+         // Fourth order dense output of the last adaptive step (Hairer's continuous extension), requires dense_output.
+         // The states are set to their values at t_sample within the step while f(t_sample) runs, then restored.
+         template <class F>
+         void interpolate(const value_t t_sample, F&& f)
+         {
+            auto& arena = propagator.arena;
+            const size_t n = arena.size();
+            auto* x0 = arena.column(0);
+            auto* xd7 = arena.column(1); // FSAL, the last stage of the step
+            auto* x1 = arena.column(3); // free once a step is complete
+            auto* xd_first = arena.column(7);
+            auto* xd_dense = arena.column(8);
+
+            const value_t theta = (t_sample - t_dense) / dt_dense;
+            const value_t theta1 = 1.0_v - theta;
+            const value_t w2 = theta * theta1;
+            const value_t w3 = theta * w2;
+            const value_t w4 = w2 * w2;
+
+            for (size_t i = 0; i < n; ++i)
+            {
+               x1[i] = *arena.x[i];
+               const value_t dx = x1[i] - x0[i];
+               const value_t dx1 = dt_dense * xd_first[i];
+               const value_t dx7 = dt_dense * xd7[i];
+               *arena.x[i] = x0[i] + theta * dx + w2 * (dx1 - dx) + w3 * (2.0_v * dx - dx1 - dx7) + w4 * (xd_dense[i] - x0[i]);
+            }
+
+            f(t_sample);
+
+            for (size_t i = 0; i < n; ++i) {
+               *arena.x[i] = x1[i];
+            }
+         }
+
+         bool dense_output = false; // keeps what interpolate needs from adaptive steps, two extra arena columns and a pass per step
+
+         value_t step_start() const noexcept { return t_dense; }
+         value_t step_size() const noexcept { return dt_dense; }
+
+         // Estimates h * |lambda| of every accepted adaptive step from its last two stages (Hairer and Wanner's DOPRI5), one extra arena column.
+         // Values beyond about 3.25 reach the boundary of the stability region, the step size is then limited by stiffness rather than accuracy.
+         bool stiffness_detection = false;
+         value_t stiffness() const noexcept { return h_lambda; }
+
       private:
+         value_t t_dense{}, dt_dense{}; // start and size of the last accepted step
+         value_t h_lambda{};
+
+         // dense output weights, d1 is 0
+         static constexpr auto d0 = cx(-12715105075.0 / 11282082432.0);
+         static constexpr auto d2 = cx(87487479700.0 / 32700410799.0);
+         static constexpr auto d3 = cx(-10690763975.0 / 1880347072.0);
+         static constexpr auto d4 = cx(701980252875.0 / 199316789632.0);
+         static constexpr auto d5 = cx(-1453857185.0 / 822651844.0);
+         static constexpr auto d6 = cx(69997945.0 / 29380423.0);
+
          static constexpr auto e0 = cx(5179.0 / 57600.0);
          // e1 is 0
          static constexpr auto e2 = cx(7571.0 / 16695.0);
@@ -25,11 +25,14 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct EulerProp : public Propagator<value_t>
+      struct EulerProp : public BatchPropagator<EulerProp<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         void batch(const StateSpan<value_t>& s, const size_t, const value_t dt)
          {
-            *state.x += dt * *state.xd;
+            const size_t n = s.size();
+            for (size_t i = 0; i < n; ++i) {
+               *s.x[i] += dt * *s.xd[i];
+            }
          }
       };
 
@@ -0,0 +1,114 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/integrators_modular/ModularIntegrators.h"
+
+// Explicit Runge Kutta integrator generated from a Butcher tableau, e.g. ExplicitRK<tableau::Ralston4, double>.
+// Each pass stores its stage derivative and forms the next stage state in one sweep, with zero weights pruned at compile time.
+
+namespace asc
+{
+   namespace modular
+   {
+      template <class tableau_t, class value_t>
+      struct ExplicitRKprop : public BatchPropagator<ExplicitRKprop<tableau_t, value_t>, value_t>
+      {
+         static constexpr size_t stages = tableau_t::stages;
+
+         ExplicitRKprop() : BatchPropagator<ExplicitRKprop<tableau_t, value_t>, value_t>(stages + 1) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
+         {
+            [&]<size_t... p>(std::index_sequence<p...>) {
+               ((pass == p ? stage<p>(s, dt) : void()), ...);
+            }(std::make_index_sequence<stages>{});
+         }
+
+      private:
+         // Stores stage derivative p and sets the states to stage p + 1, the solution on the last pass
+         template <size_t p>
+         void stage(const StateSpan<value_t>& s, const value_t dt)
+         {
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xdp = s.column(p + 1);
+
+            tableau::with_nonzero<tableau_t, p + 1>([&]<size_t... j>(std::index_sequence<j...>) {
+               for (size_t i = 0; i < n; ++i)
+               {
+                  if constexpr (p == 0) {
+                     x0[i] = *s.x[i];
+                  }
+                  xdp[i] = *s.xd[i];
+                  if constexpr (sizeof...(j) == 0) {
+                     *s.x[i] = x0[i];
+                  }
+                  else {
+                     *s.x[i] = x0[i] + dt * ((static_cast<value_t>(tableau::weight<tableau_t, p + 1, j>) * s.column(j + 1)[i]) + ...);
+                  }
+               }
+            });
+         }
+      };
+
+      template <class tableau_t, class value_t>
+      struct ExplicitRKstepper : public TimeStepper<value_t>
+      {
+         value_t t0{};
+
+         void operator()(const size_t pass, value_t& t, const value_t dt) override
+         {
+            if (pass == 0) {
+               t0 = t;
+            }
+
+            if (pass + 1 < tableau_t::stages) {
+               t = t0 + static_cast<value_t>(tableau_t::c[pass + 1]) * dt;
+            }
+            else {
+               t = t0 + dt;
+            }
+         }
+      };
+
+      template <class tableau_t, class value_t>
+      struct ExplicitRK
+      {
+         static constexpr size_t n_substeps = tableau_t::stages;
+
+         asc::Module* run_first{};
+
+         ExplicitRKprop<tableau_t, value_t> propagator;
+         ExplicitRKstepper<tableau_t, value_t> stepper;
+
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, const value_t dt)
+         {
+            auto& pass = propagator.pass;
+            for (pass = 0; pass < n_substeps; ++pass)
+            {
+               update(blocks, run_first);
+               apply(blocks);
+               propagate(blocks, propagator, dt);
+               stepper(pass, t, dt);
+               postprop(blocks);
+            }
+         }
+      };
+   }
+}
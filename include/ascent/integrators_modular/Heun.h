@@ -24,25 +24,29 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct Heunprop : public Propagator<value_t>
+      struct Heunprop : public BatchPropagator<Heunprop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         Heunprop() : BatchPropagator<Heunprop<value_t>, value_t>(2) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            state.memory.resize(2);
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;          //k1  
-               x = x0 + dt * xd;  
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];          //k1  
+                  *s.x[i] = x0[i] + dt * xd0[i];  
+               }
                break;
             case 1:
-               x = x0 + dt * 0.5 * ( xd0 + xd );
+               for (size_t i = 0; i < n; ++i) {
+                  *s.x[i] = x0[i] + dt * 0.5 * ( xd0[i] + *s.xd[i] );
+               }
                break;
             }
          }
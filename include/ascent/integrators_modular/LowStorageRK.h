@@ -0,0 +1,205 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+#include "ascent/algorithms/ButcherTableau.h"
+#include "ascent/integrators_modular/ModularIntegrators.h"
+#include "ascent/timing/Timing.h"
+#include "ascent/Utility.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Low storage (Williamson 2N) Runge Kutta, e.g. LowStorageRK<tableau::CK45, double>.
+// The modules hold the states and derivatives, so a fixed step needs a single arena column (dx) and each pass is one sweep.
+// The adaptive step of a scheme with error weights adds the start state and the error register.
+
+namespace asc
+{
+   namespace modular
+   {
+      template <class scheme_t, class value_t>
+      struct LowStorageRKprop : public BatchPropagator<LowStorageRKprop<scheme_t, value_t>, value_t>
+      {
+         static constexpr size_t stages = scheme_t::stages;
+
+         LowStorageRKprop() : BatchPropagator<LowStorageRKprop<scheme_t, value_t>, value_t>(1) {}
+
+         bool adaptive = false; // also records the start state (column 1) and accumulates the error (column 2)
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
+         {
+            if constexpr (requires { scheme_t::E; })
+            {
+               if (adaptive)
+               {
+                  dispatch<true>(s, pass, dt);
+                  return;
+               }
+            }
+            dispatch<false>(s, pass, dt);
+         }
+
+      private:
+         template <bool error>
+         void dispatch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
+         {
+            [&]<size_t... p>(std::index_sequence<p...>) {
+               ((pass == p ? stage<p, error>(s, dt) : void()), ...);
+            }(std::make_index_sequence<stages>{});
+         }
+
+         template <size_t p, bool error>
+         void stage(const StateSpan<value_t>& s, const value_t dt)
+         {
+            constexpr auto a = static_cast<value_t>(scheme_t::A[p]);
+            constexpr auto b = static_cast<value_t>(scheme_t::B[p]);
+
+            const size_t n = s.size();
+            auto* dx = s.column(0);
+            for (size_t i = 0; i < n; ++i)
+            {
+               const value_t xd = *s.xd[i];
+               if constexpr (error)
+               {
+                  constexpr auto e = static_cast<value_t>(scheme_t::E[p]);
+                  auto* x0 = s.column(1);
+                  auto* err = s.column(2);
+                  if constexpr (p == 0)
+                  {
+                     x0[i] = *s.x[i];
+                     err[i] = e * dt * xd;
+                  }
+                  else {
+                     err[i] += e * dt * xd;
+                  }
+               }
+
+               if constexpr (p == 0) {
+                  dx[i] = dt * xd;
+               }
+               else {
+                  dx[i] = a * dx[i] + dt * xd;
+               }
+               *s.x[i] += b * dx[i];
+            }
+         }
+      };
+
+      template <class scheme_t, class value_t>
+      struct LowStorageRKstepper : public TimeStepper<value_t>
+      {
+         value_t t0{};
+
+         void operator()(const size_t pass, value_t& t, const value_t dt) override
+         {
+            if (pass == 0) {
+               t0 = t;
+            }
+
+            if (pass + 1 < scheme_t::stages) {
+               t = t0 + static_cast<value_t>(scheme_t::C[pass + 1]) * dt;
+            }
+            else {
+               t = t0 + dt;
+            }
+         }
+      };
+
+      template <class scheme_t, class value_t>
+      struct LowStorageRK : AdaptiveIntegrator
+      {
+         static constexpr size_t n_substeps = scheme_t::stages;
+
+         LowStorageRKprop<scheme_t, value_t> propagator;
+         LowStorageRKstepper<scheme_t, value_t> stepper;
+
+         asc::Timing<double>* run_first{};
+
+         StepControllerT<value_t> controller = StepControllerT<value_t>::PI(); // used by adaptive steps, dt <= 0 estimates the first step
+
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, const value_t dt)
+         {
+            auto& pass = propagator.pass;
+            for (pass = 0; pass < n_substeps; ++pass)
+            {
+               update(blocks, run_first);
+               apply(blocks);
+               propagate(blocks, propagator, dt);
+               stepper(pass, t, dt);
+               postprop(blocks);
+            }
+         }
+
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings) requires requires { scheme_t::E; }
+         {
+            constexpr value_t order = static_cast<value_t>(scheme_t::embedded_order + 1); // the error estimate is O(dt^order)
+
+            auto& arena = propagator.arena;
+            if (!propagator.adaptive)
+            {
+               propagator.adaptive = true;
+               arena.columns(3);
+            }
+
+            if (dt <= 0.0_v) // estimate the first step
+            {
+               dt = initial_step(blocks, t, scheme_t::embedded_order + 1, settings);
+
+               if (run_first) {
+                  run_first->base_time_step(dt);
+               }
+            }
+
+            const value_t t0 = t;
+
+            while (true)
+            {
+               operator()(blocks, t, dt);
+
+               const size_t n = arena.size();
+               auto* x0 = arena.column(1);
+               auto* err = arena.column(2);
+
+               const value_t e = error_norm(blocks, propagator, settings, [&](const size_t i) {
+                  return std::abs(err[i]);
+               }, [&](const size_t i) {
+                  return std::max(std::abs(x0[i]), std::abs(*arena.x[i]));
+               });
+
+               const value_t factor = controller(e, order, settings.safety_factor);
+               dt *= factor;
+
+               if (run_first) {
+                  run_first->base_time_step(dt);
+               }
+
+               if (e > 1.0_v)
+               {
+                  t = t0;
+                  for (size_t i = 0; i < n; ++i) {
+                     *arena.x[i] = x0[i];
+                  }
+                  continue;
+               }
+               return;
+            }
+         }
+      };
+   }
+}
@@ -22,20 +22,20 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct MidpointProp : public Propagator<value_t>
+      struct MidpointProp : public BatchPropagator<MidpointProp<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         MidpointProp() : BatchPropagator<MidpointProp<value_t>, value_t>(1) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t, const value_t dt)
          {
-            if (state.memory.empty())
-            {
-               state.memory.resize(1);
-               state.memory[0] = 0.0;
+            const size_t n = s.size();
+            auto* xd0 = s.column(0); // zero initialized by the arena
+
+            for (size_t i = 0; i < n; ++i) {
+               const auto xd = *s.xd[i];
+               *s.x[i] += 0.5 * dt * (xd0[i] + xd);
+               xd0[i] = xd;
             }
-            auto& xd0 = state.memory[0];
-            
-            auto& xd = *state.xd;
-            *state.x += 0.5 * dt * (xd0 + xd);
-            xd0 = xd;
          }
       };
    }
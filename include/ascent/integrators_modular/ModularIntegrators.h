@@ -14,6 +14,17 @@
 
 #pragma once
 
+#include "ascent/algorithms/Sparse.h"
+#include "ascent/algorithms/StepController.h"
+#include "ascent/modular/Link.h"
+#include "ascent/modular/Module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace asc
 {
    namespace modular
@@ -30,5 +41,164 @@ namespace asc
 
          virtual void operator()(const size_t, value_t&, const value_t) = 0; // inputs: pass, t (time), dt (time step)
       };
+
+      // Starting step size for an adaptive modular integrator of the given order, see asc::initial_step.
+      // Evaluates the blocks at t and once more at an Euler probe, then restores their states and t. States are scaled by their Module::tolerances.
+      template <class modules_t, class value_t>
+      value_t initial_step(modules_t& blocks, value_t& t, const size_t order, const AdaptiveT<value_t>& settings)
+      {
+         std::vector<State*> states;
+         AdaptiveT<value_t> scaled = settings;
+         scaled.abs_tols.clear();
+         scaled.rel_tols.clear();
+         for (auto& block : blocks)
+         {
+            auto& module = deref(block);
+            const size_t n_tol = std::min(module.tolerances.size(), module.states.size());
+            if (n_tol > 0 && scaled.abs_tols.empty()) {
+               scaled.components(states.size());
+            }
+            for (size_t j = 0; j < module.states.size(); ++j)
+            {
+               states.emplace_back(&module.states[j]);
+               if (scaled.abs_tols.empty()) {
+                  continue;
+               }
+               const Tolerance tol = j < n_tol ? module.tolerances[j] : Tolerance{};
+               scaled.abs_tols.emplace_back(tol.abs_tol < 0.0 ? settings.abs_tol : static_cast<value_t>(tol.abs_tol));
+               scaled.rel_tols.emplace_back(tol.rel_tol < 0.0 ? settings.rel_tol : static_cast<value_t>(tol.rel_tol));
+            }
+         }
+
+         const size_t n = states.size();
+         std::vector<value_t> x0(n), xd0(n), x1, xd1;
+
+         const value_t t0 = t;
+         auto system = [&](const std::vector<value_t>& x, std::vector<value_t>& xd, const value_t ts) {
+            for (size_t i = 0; i < n; ++i) {
+               *states[i]->x = x[i];
+            }
+            t = ts;
+            update(blocks);
+            apply(blocks);
+            for (size_t i = 0; i < n; ++i) {
+               xd[i] = *states[i]->xd;
+            }
+         };
+
+         for (size_t i = 0; i < n; ++i) {
+            x0[i] = *states[i]->x;
+         }
+         system(x0, xd0, t0);
+         const value_t dt = asc::initial_step(system, x0, xd0, x1, xd1, t0, order, scaled);
+
+         for (size_t i = 0; i < n; ++i) {
+            *states[i]->x = x0[i];
+         }
+         t = t0;
+         return dt;
+      }
+
+      // Error norm of an adaptive step over the arena rows of the propagator, see simd::error_norm.
+      // err(i) is the absolute error estimate of row i and scale(i) the magnitude its relative tolerance applies to.
+      template <class modules_t, class propagator_t, class value_t, class Err, class Scale>
+      value_t error_norm(modules_t& blocks, propagator_t& propagator, const AdaptiveT<value_t>& settings, Err&& err, Scale&& scale)
+      {
+         auto& arena = propagator.arena;
+         arena.tolerances(blocks, settings.abs_tol, settings.rel_tol);
+         const value_t* abs_tol = arena.abs_tol.data();
+         const value_t* rel_tol = arena.rel_tol.data();
+
+         auto rows = [&]<bool rms, bool per_row>() {
+            return [&](const size_t begin, const size_t end) {
+               value_t acc{};
+               for (size_t i = begin; i < end; ++i)
+               {
+                  const value_t a = per_row ? abs_tol[i] : settings.abs_tol;
+                  const value_t r = per_row ? rel_tol[i] : settings.rel_tol;
+                  const value_t q = err(i) / (a + r * scale(i));
+                  acc = rms ? acc + q * q : std::max(acc, q);
+               }
+               return acc;
+            };
+         };
+
+         const bool per_row = !arena.abs_tol.empty();
+         if (settings.norm == Norm::RMS)
+         {
+            const value_t sum = per_row ? sum_rows(propagator, rows.template operator()<true, true>()) : sum_rows(propagator, rows.template operator()<true, false>());
+            return std::sqrt(sum / static_cast<value_t>(std::max<size_t>(arena.size(), 1)));
+         }
+         return per_row ? max_rows(propagator, rows.template operator()<false, true>()) : max_rows(propagator, rows.template operator()<false, false>());
+      }
+
+      // Sparsity pattern of the Jacobian over the arena rows, from the Link connectivity of the blocks, which must be numbered by an arena.
+      // The derivatives of a module depend on its own states and on the states of the modules it accesses through Links.
+      // A module without states that links several modules, e.g. a spring applying forces to its end masses, couples all of them.
+      // Outputs that a linked module computes from further modules are not followed, so the pattern may miss entries:
+      // it suits approximate Jacobians such as preconditioners.
+      template <class modules_t>
+      void link_sparsity(modules_t& blocks, SparsityPattern& pattern)
+      {
+         std::unordered_map<Module*, size_t> index;
+         std::vector<Module*> modules;
+         size_t n{};
+         for (auto& block : blocks)
+         {
+            auto& module = deref(block);
+            index.emplace(&module, modules.size());
+            modules.emplace_back(&module);
+            n += module.states.size();
+         }
+
+         std::vector<std::vector<size_t>> depends(modules.size()); // modules whose states each module's derivatives depend on
+         std::vector<std::vector<size_t>> accessed(modules.size());
+         for (size_t m = 0; m < modules.size(); ++m) {
+            depends[m].emplace_back(m);
+         }
+         // an update pass reporting the Link accesses of every module, Links do not sequence it
+         LinkTrace trace;
+         {
+            ActiveTrace active(trace);
+            for (auto* module : modules)
+            {
+               trace.caller = module;
+               if (!(module->no_op & phase_bit(Phase::Update))) (*module)();
+            }
+         }
+
+         for (auto& [caller, callee] : trace.edges)
+         {
+            const auto from = index.find(caller);
+            const auto to = index.find(callee);
+            if (from == index.end() || to == index.end() || from == to) {
+               continue;
+            }
+            depends[from->second].emplace_back(to->second);
+            accessed[from->second].emplace_back(to->second);
+         }
+         for (size_t m = 0; m < modules.size(); ++m)
+         {
+            if (!modules[m]->states.empty()) {
+               continue;
+            }
+            for (auto p : accessed[m]) {
+               depends[p].insert(depends[p].end(), accessed[m].begin(), accessed[m].end());
+            }
+         }
+
+         std::vector<std::vector<size_t>> rows(n);
+         for (size_t m = 0; m < modules.size(); ++m)
+         {
+            for (auto& state : modules[m]->states)
+            {
+               auto& row = rows[state.index];
+               for (auto d : depends[m]) {
+                  for (auto& s : modules[d]->states) row.emplace_back(s.index);
+               }
+            }
+         }
+         pattern.assign(rows);
+      }
    }
-}
\ No newline at end of file
+}
@@ -28,36 +28,40 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct PC233prop : public Propagator<value_t>
+      struct PC233prop : public BatchPropagator<PC233prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         PC233prop() : BatchPropagator<PC233prop<value_t>, value_t>(5) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 5) {
-               state.memory.resize(5);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
-            auto& xd_1 = state.memory[4];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
+            auto* xd_1 = s.column(4);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + c0 * dt * (7 * xd0 - xd_1);   // X(n + 1/3), third step computation
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + c0 * dt * (7 * xd0[i] - xd_1[i]);   // X(n + 1/3), third step computation
+               }
                break;
             case 1:
-               xd1 = xd;
-               x = x0 + c1 * dt * (39 * xd1 - 4 * xd0 + xd_1);   // X(n + 2/3), two thirds step computation
+               for (size_t i = 0; i < n; ++i) {
+                  xd1[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + c1 * dt * (39 * xd1[i] - 4 * xd0[i] + xd_1[i]);   // X(n + 2/3), two thirds step computation
+               }
                break;
             case 2:
-               xd2 = xd;
-               x = x0 + c2 * dt * (xd0 + 3 * xd2);
-               xd_1 = xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  xd2[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + c2 * dt * (xd0[i] + 3 * xd2[i]);
+                  xd_1[i] = xd0[i];
+               }
                break;
             }
          }
@@ -112,31 +116,15 @@ namespace asc
                }
                // Run initializer integrator
                initializer(blocks, t, dt);
+               propagator.arena.sync(blocks);
 
-               if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-               {
-                  // Assign previous time step's derivative
-                  for (auto& block : blocks)
-                  {
-                     for (auto& state : block.second->states)
-                     {
-                        state.memory.resize(5);
-                        auto& xd_1 = state.memory[4];
-                        xd_1 = *state.xd;
-                     }
-                  }
-               }
-               else
+               // Assign previous time step's derivative
+               for (auto& block : blocks)
                {
-                  // Assign previous time step's derivative
-                  for (auto& block : blocks)
+                  for (auto& state : deref(block).states)
                   {
-                     for (auto& state : block->states)
-                     {
-                        state.memory.resize(5);
-                        auto& xd_1 = state.memory[4];
-                        xd_1 = *state.xd;
-                     }
+                     auto& xd_1 = propagator.arena(4, state.index);
+                     xd_1 = *state.xd;
                   }
                }
 
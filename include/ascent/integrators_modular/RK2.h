@@ -25,26 +25,27 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RK2prop : public Propagator<value_t>
+      struct RK2prop : public BatchPropagator<RK2prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RK2prop() : BatchPropagator<RK2prop<value_t>, value_t>(1) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 1)
-            {
-               state.memory.resize(1);
-            }
-            auto& x0 = state.memory[0];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               x = x0 + 0.5 * dt * xd;
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  *s.x[i] = x0[i] + 0.5 * dt * *s.xd[i];
+               }
                break;
             case 1:
-               x = x0 + dt * xd;
+               for (size_t i = 0; i < n; ++i) {
+                  *s.x[i] = x0[i] + dt * *s.xd[i];
+               }
                break;
             default:
                break;
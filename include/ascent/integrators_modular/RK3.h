@@ -24,32 +24,38 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RK3prop : public Propagator<value_t>
+      struct RK3prop : public BatchPropagator<RK3prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RK3prop() : BatchPropagator<RK3prop<value_t>, value_t>(4) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            state.memory.resize(4);
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;  // k1
-               x = x0 + dt * (1.0/3.0) * xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];  // k1
+                  *s.x[i] = x0[i] + dt * (1.0/3.0) * xd0[i];
+               }
                break;
             case 1:
-               xd1 = xd;  // k2
-               x = x0 + dt * (2.0/3.0) * xd1;
+               for (size_t i = 0; i < n; ++i) {
+                  xd1[i] = *s.xd[i];  // k2
+                  *s.x[i] = x0[i] + dt * (2.0/3.0) * xd1[i];
+               }
                break;
             case 2:
-               xd2 = xd;  // k3
-               x = x0 + dt * ( (1.0/4.0)*xd0 + (3.0/4.0)*xd2 );
+               for (size_t i = 0; i < n; ++i) {
+                  xd2[i] = *s.xd[i];  // k3
+                  *s.x[i] = x0[i] + dt * ( (1.0/4.0)*xd0[i] + (3.0/4.0)*xd2[i] );
+               }
                break;
             }
          }
@@ -22,40 +22,45 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RK4prop : public Propagator<value_t>
+      struct RK4prop : public BatchPropagator<RK4prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RK4prop() : BatchPropagator<RK4prop<value_t>, value_t>(5) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 5)
-            {
-               state.memory.resize(5);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
-            auto& xd3 = state.memory[4];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
+            auto* xd3 = s.column(4);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + 0.5 * dt * xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + 0.5 * dt * xd0[i];
+               }
                break;
             case 1:
-               xd1 = xd;
-               x = x0 + 0.5 * dt * xd1;
+               for (size_t i = 0; i < n; ++i) {
+                  xd1[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + 0.5 * dt * xd1[i];
+               }
                break;
             case 2:
-               xd2 = xd;
-               x = x0 + dt * xd2;
+               for (size_t i = 0; i < n; ++i) {
+                  xd2[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt * xd2[i];
+               }
                break;
             case 3:
-               xd3 = xd;
-               x = x0 + dt / 6.0 * (xd0 + 2 * xd1 + 2 * xd2 + xd3);
+               for (size_t i = 0; i < n; ++i) {
+                  xd3[i] = *s.xd[i];
+                  *s.x[i] = x0[i] + dt / 6.0 * (xd0[i] + 2 * xd1[i] + 2 * xd2[i] + xd3[i]);
+               }
                break;
             }
          }
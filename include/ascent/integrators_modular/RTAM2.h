@@ -26,28 +26,30 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RTAM2prop : public Propagator<value_t>
+      struct RTAM2prop : public BatchPropagator<RTAM2prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RTAM2prop() : BatchPropagator<RTAM2prop<value_t>, value_t>(2) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 2)
-            {
-               state.memory.resize(2);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd1 = state.memory[1];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd1 = s.column(1);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               x = x0 + dt / 8 * (5 * xd - xd1);
-               xd1 = xd;
+               for (size_t i = 0; i < n; ++i) {
+                  const auto xd = *s.xd[i];
+                  x0[i] = *s.x[i];
+                  *s.x[i] = x0[i] + dt / 8 * (5 * xd - xd1[i]);
+                  xd1[i] = xd;
+               }
                break;
             case 1:
-               x = x0 + dt * xd; // where xd is the evaluated derivative at n + 1/2 (half a step)
+               for (size_t i = 0; i < n; ++i) {
+                  *s.x[i] = x0[i] + dt * *s.xd[i]; // where xd is the evaluated derivative at n + 1/2 (half a step)
+               }
                break;
             }
          }
@@ -26,32 +26,34 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RTAM3prop : public Propagator<value_t>
+      struct RTAM3prop : public BatchPropagator<RTAM3prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RTAM3prop() : BatchPropagator<RTAM3prop<value_t>, value_t>(4) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 4)
-            {
-               state.memory.resize(4);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + dt / 24 * (17 * xd - 7 * xd1 + 2 * xd2);
+               for (size_t i = 0; i < n; ++i) {
+                  const auto xd = *s.xd[i];
+                  x0[i] = *s.x[i];
+                  xd0[i] = xd;
+                  *s.x[i] = x0[i] + dt / 24 * (17 * xd - 7 * xd1[i] + 2 * xd2[i]);
+               }
                break;
             case 1:
-               x = x0 + dt / 18 * (20 * xd - 3 * xd0 + xd1);
-               xd2 = xd1;
-               xd1 = xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  *s.x[i] = x0[i] + dt / 18 * (20 * *s.xd[i] - 3 * xd0[i] + xd1[i]);
+                  xd2[i] = xd1[i];
+                  xd1[i] = xd0[i];
+               }
                break;
             }
          }
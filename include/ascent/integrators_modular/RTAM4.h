@@ -26,34 +26,36 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct RTAM4prop : public Propagator<value_t>
+      struct RTAM4prop : public BatchPropagator<RTAM4prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         RTAM4prop() : BatchPropagator<RTAM4prop<value_t>, value_t>(5) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            if (state.memory.size() < 5)
-            {
-               state.memory.resize(5);
-            }
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
-            auto& xd3 = state.memory[4];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
+            auto* xd3 = s.column(4);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;
-               x = x0 + dt / 384 * (297 * xd - 187 * xd1 + 107 * xd2 - 25 * xd3);
+               for (size_t i = 0; i < n; ++i) {
+                  const auto xd = *s.xd[i];
+                  x0[i] = *s.x[i];
+                  xd0[i] = xd;
+                  *s.x[i] = x0[i] + dt / 384 * (297 * xd - 187 * xd1[i] + 107 * xd2[i] - 25 * xd3[i]);
+               }
                break;
             case 1:
-               x = x0 + dt / 30 * (36 * xd - 10 * xd0 + 5 * xd1 - xd2);
-               xd3 = xd2;
-               xd2 = xd1;
-               xd1 = xd0;
+               for (size_t i = 0; i < n; ++i) {
+                  *s.x[i] = x0[i] + dt / 30 * (36 * *s.xd[i] - 10 * xd0[i] + 5 * xd1[i] - xd2[i]);
+                  xd3[i] = xd2[i];
+                  xd2[i] = xd1[i];
+                  xd1[i] = xd0[i];
+               }
                break;
             }
          }
@@ -24,37 +24,45 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct Ralston4prop : public Propagator<value_t>
+      struct Ralston4prop : public BatchPropagator<Ralston4prop<value_t>, value_t>
       {
-         void operator()(State& state, const value_t dt) override
+         Ralston4prop() : BatchPropagator<Ralston4prop<value_t>, value_t>(5) {}
+
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t dt)
          {
-            auto& x = *state.x;
-            auto& xd = *state.xd;
-            state.memory.resize(5);
-            auto& x0 = state.memory[0];
-            auto& xd0 = state.memory[1];
-            auto& xd1 = state.memory[2];
-            auto& xd2 = state.memory[3];
-            auto& xd3 = state.memory[4];
+            const size_t n = s.size();
+            auto* x0 = s.column(0);
+            auto* xd0 = s.column(1);
+            auto* xd1 = s.column(2);
+            auto* xd2 = s.column(3);
+            auto* xd3 = s.column(4);
 
-            switch (Propagator<value_t>::pass)
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               xd0 = xd;  // k1
-               x = x0 + dt * (0.4 * xd0);
+               for (size_t i = 0; i < n; ++i) {
+                  x0[i] = *s.x[i];
+                  xd0[i] = *s.xd[i];  // k1
+                  *s.x[i] = x0[i] + dt * (0.4 * xd0[i]);
+               }
                break;
             case 1:
-               xd1 = xd;  // k2
-               x = x0 + dt * (0.29697761 * xd0 + 0.15875964 * xd1);
+               for (size_t i = 0; i < n; ++i) {
+                  xd1[i] = *s.xd[i];  // k2
+                  *s.x[i] = x0[i] + dt * (0.29697761 * xd0[i] + 0.15875964 * xd1[i]);
+               }
                break;
             case 2:
-               xd2 = xd;  // k3
-               x = x0 + dt * (0.21810040 * xd0 - 3.05096516 * xd1 + 3.83286476 * xd2);
+               for (size_t i = 0; i < n; ++i) {
+                  xd2[i] = *s.xd[i];  // k3
+                  *s.x[i] = x0[i] + dt * (0.21810040 * xd0[i] - 3.05096516 * xd1[i] + 3.83286476 * xd2[i]);
+               }
                break;
             case 3:
-               xd3 = xd; // k4
-               x = x0 + dt * (0.17476028 * xd0 - 0.55148066 * xd1 + 1.20553560 * xd2 + 0.17118478 * xd3);
+               for (size_t i = 0; i < n; ++i) {
+                  xd3[i] = *s.xd[i]; // k4
+                  *s.x[i] = x0[i] + dt * (0.17476028 * xd0[i] - 0.55148066 * xd1[i] + 1.20553560 * xd2[i] + 0.17118478 * xd3[i]);
+               }
                break;
             }
          }
@@ -111,6 +119,7 @@ namespace asc
             update(blocks, run_first);
             apply(blocks);
             propagate(blocks, propagator, dt);
+            stepper(pass, t, dt);
             postprop(blocks);
             ++pass;
 
@@ -0,0 +1,651 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+#include "ascent/algorithms/Jacobian.h"
+#include "ascent/algorithms/Sparse.h"
+#include "ascent/integrators_modular/ModularIntegrators.h"
+#include "ascent/timing/Timing.h"
+#include "ascent/Utility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Implicit TR-BDF2 for stiff modular systems (Bank et al., Hosea and Shampine): a trapezoidal stage to t + gamma * dt followed by a BDF2 stage to t + dt.
+// Both stages solve Y = base + d * dt * f(Y) by Jacobian-free Newton-Krylov, no Jacobian is ever assembled:
+// the Newton corrections come from GMRES, whose products J v are directional differences of the derivatives, each one an extra update pass of the blocks.
+// Adaptive steps take the third order embedded solution's error estimate, filtered through I - d * dt * J (Hairer and Wanner) so that stiff states do not inflate it.
+// GMRES is preconditioned by the sparse LU of I - d * dt * J, with J estimated by colored differences over the Link connectivity of the blocks (see link_sparsity).
+// That Jacobian only needs to be approximate, it is kept for max_jacobian_age steps and costs one update pass per color.
+// The states are set directly through the arena, so modules that override propagate() are treated as if they kept the default.
+
+namespace asc
+{
+   namespace modular
+   {
+      // Loads the states from arena column pass, the solver sets its trial states through it
+      template <class value_t>
+      struct TRBDF2prop : public BatchPropagator<TRBDF2prop<value_t>, value_t>
+      {
+         void batch(const StateSpan<value_t>& s, const size_t pass, const value_t)
+         {
+            const size_t n = s.size();
+            const auto* x = s.column(pass);
+            for (size_t i = 0; i < n; ++i) {
+               *s.x[i] = x[i];
+            }
+         }
+      };
+
+      template <class value_t>
+      struct TRBDF2 : AdaptiveIntegrator
+      {
+         TRBDF2prop<value_t> propagator;
+
+         asc::Timing<double>* run_first{};
+
+         bool fsal_computed = false; // the derivatives at the start of the step are known from the last step
+
+         StepControllerT<value_t> controller = StepControllerT<value_t>::PI(); // used by adaptive steps, dt <= 0 estimates the first step
+         size_t max_newton = 5; // Newton iterations per stage
+         size_t krylov_dim = 20; // GMRES iterations per Newton iteration
+         value_t krylov_tol = 0.05_v; // GMRES stops at this fraction of the Newton tolerance, in the weighted root mean square norm
+         value_t fixed_tol = 1.0e-8_v; // tolerance of the Newton iterations of fixed steps
+         bool precondition = true; // preconditions GMRES with a sparse Jacobian from the Link connectivity
+         size_t max_jacobian_age = 20; // accepted steps a preconditioner Jacobian is kept for
+
+         size_t evaluations{}; // update passes of the blocks
+         size_t krylov_iterations{};
+         size_t n_jacobians{};
+         size_t n_colors{}; // update passes per preconditioner Jacobian
+
+         // Detects the Link connectivity again on the next step, e.g. after Links have been reassigned
+         void invalidate() noexcept { J.pattern.clear(); }
+
+         // Evaluates the derivatives and the preconditioner Jacobian afresh on the next step, e.g. after the states changed discontinuously
+         void reset() noexcept
+         {
+            fsal_computed = false;
+            jacobian_age = max_jacobian_age;
+         }
+
+         // Infinity norm of the preconditioner Jacobian, a bound of the spectral radius of the system, infinite without one
+         value_t jacobian_norm() const noexcept
+         {
+            if (!precondition || n_jacobians == 0 || J.size() == 0) {
+               return std::numeric_limits<value_t>::infinity();
+            }
+            value_t result{};
+            const auto& pattern = J.pattern;
+            for (size_t i = 0; i < pattern.size(); ++i)
+            {
+               value_t s{};
+               for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+                  s += std::abs(J.values[k]);
+               }
+               result = std::max(result, s);
+            }
+            return result;
+         }
+
+         // Fixed step, throws if the Newton iterations do not converge
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, const value_t dt)
+         {
+            AdaptiveT<value_t> settings;
+            settings.abs_tol = fixed_tol;
+            settings.rel_tol = fixed_tol;
+
+            const value_t t0 = t;
+            prepare(blocks, t, settings);
+            value_t e{};
+            bool converged = step(blocks, t, t0, dt, settings, false, e);
+            if (!converged && precondition && !jacobian_current)
+            {
+               jacobian(blocks, t, t0);
+               converged = step(blocks, t, t0, dt, settings, false, e);
+            }
+            if (!converged) {
+               throw std::runtime_error("TRBDF2: Newton iterations did not converge at t = " + std::to_string(t0));
+            }
+            accept(blocks, t, t0 + dt);
+         }
+
+         template <class modules_t>
+         void operator()(modules_t& blocks, value_t& t, value_t& dt, const AdaptiveT<value_t>& settings)
+         {
+            const value_t t0 = t;
+
+            if (dt <= 0.0_v) // estimate the first step
+            {
+               dt = initial_step(blocks, t, 2, settings);
+
+               if (run_first) {
+                  run_first->base_time_step(dt);
+               }
+            }
+
+            prepare(blocks, t, settings);
+
+            while (true)
+            {
+               if (dt < 10 * std::numeric_limits<value_t>::epsilon() * std::max(std::abs(t0), 1.0_v)) {
+                  throw std::runtime_error("TRBDF2: step size underflow at t = " + std::to_string(t0));
+               }
+
+               value_t e{};
+               const bool converged = step(blocks, t, t0, dt, settings, true, e);
+               if (!converged && precondition && !jacobian_current)
+               {
+                  jacobian(blocks, t, t0); // a stale preconditioner may have stalled the iterations, retry with a fresh one
+                  continue;
+               }
+               const value_t factor = converged ? controller(e, 3.0_v, settings.safety_factor) : 0.5_v; // the error estimate is O(dt^3)
+
+               if (!converged || e > 1.0_v)
+               {
+                  dt *= factor;
+                  t = t0;
+
+                  if (run_first) {
+                     run_first->base_time_step(dt);
+                  }
+                  continue;
+               }
+
+               accept(blocks, t, t0 + dt);
+               dt *= factor;
+
+               if (run_first) {
+                  run_first->base_time_step(dt);
+               }
+               return;
+            }
+         }
+
+      private:
+         static constexpr value_t gamma = cx(2.0 - 1.4142135623730951); // 2 - sqrt(2), the trapezoidal stage ends at t + gamma * dt
+         static constexpr value_t d = cx(1.0 - 0.70710678118654757); // gamma / 2, the implicit weight of both stages
+         static constexpr value_t w = cx(0.35355339059327379); // sqrt(2) / 4, the explicit weights of the BDF2 stage
+         // b - bhat, the solution minus the third order embedded solution
+         static constexpr value_t e0 = cx((4.0 * 0.35355339059327379 - 1.0) / 3.0);
+         static constexpr value_t e1 = cx(-1.0 / 3.0);
+         static constexpr value_t e2 = cx(2.0 * (1.0 - 0.70710678118654757) / 3.0);
+
+         // arena columns, followed by the krylov_dim + 1 Krylov basis vectors
+         static constexpr size_t X0 = 0, F0 = 1, F1 = 2, F2 = 3, BASE = 4, Y = 5, FY = 6, DY = 7, WORK = 8, WEIGHT = 9, Z = 10, V = 11;
+
+         SparseMatrixT<value_t> J, M; // preconditioner Jacobian and iteration matrix
+         SparseLUT<value_t> lu;
+         std::vector<size_t> colors;
+         size_t jacobian_age{};
+         bool jacobian_current = false; // J was estimated at the start of the current step
+         value_t c_factored{}; // c of the factored iteration matrix, zero if not factored
+
+         // Numbers the states, sizes the arena and gathers the start of the step
+         template <class modules_t>
+         void prepare(modules_t& blocks, value_t& t, const AdaptiveT<value_t>& settings)
+         {
+            auto& arena = propagator.arena;
+            propagator.pass = 0;
+            if (arena.sync(blocks)) {
+               fsal_computed = false;
+            }
+            if (propagator.history) {
+               propagator.history->record();
+            }
+            if (arena.columns() != V + krylov_dim + 1)
+            {
+               arena.columns(V + krylov_dim + 1);
+               fsal_computed = false;
+            }
+
+            // weights of the inner product, 1 / (abs_tol + rel_tol * |x0|), states excluded from error control still need to be solved for
+            arena.tolerances(blocks, settings.abs_tol, settings.rel_tol);
+            const bool per_row = !arena.abs_tol.empty();
+            auto* x0 = arena.column(X0);
+            auto* weight = arena.column(WEIGHT);
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i)
+               {
+                  x0[i] = *arena.x[i];
+                  value_t a = per_row ? arena.abs_tol[i] : settings.abs_tol;
+                  value_t r = per_row ? arena.rel_tol[i] : settings.rel_tol;
+                  if (!std::isfinite(a))
+                  {
+                     a = settings.abs_tol;
+                     r = settings.rel_tol;
+                  }
+                  weight[i] = 1.0_v / (a + r * std::abs(x0[i]));
+               }
+            });
+
+            if (!fsal_computed) {
+               evaluate(blocks, t, t, X0, F0);
+            }
+
+            jacobian_current = false;
+            if (precondition)
+            {
+               if (J.size() != arena.size())
+               {
+                  SparsityPattern pattern;
+                  link_sparsity(blocks, pattern);
+                  n_colors = color_columns(pattern, colors);
+                  J.assign(pattern);
+                  M.assign(pattern);
+                  lu.analyze(pattern);
+                  jacobian_age = max_jacobian_age;
+               }
+               if (jacobian_age >= max_jacobian_age) {
+                  jacobian(blocks, t, t);
+               }
+            }
+         }
+
+         // Estimates the preconditioner Jacobian at column X0, whose derivatives are in F0, one update pass per color
+         template <class modules_t>
+         void jacobian(modules_t& blocks, value_t& t, const value_t t0)
+         {
+            auto& arena = propagator.arena;
+            const size_t n = arena.size();
+            const auto* x0 = arena.column(X0);
+            const auto* f0 = arena.column(F0);
+            auto* work = arena.column(WORK);
+            const auto& pattern = J.pattern;
+            using delta_t = JacobianT<std::vector<value_t>>;
+
+            for (size_t c = 0; c < n_colors; ++c)
+            {
+               for (size_t j = 0; j < n; ++j) {
+                  work[j] = colors[j] == c ? x0[j] + delta_t::delta(x0[j]) : x0[j];
+               }
+               evaluate(blocks, t, t0, WORK, WORK);
+
+               for (size_t i = 0; i < n; ++i)
+               {
+                  for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k)
+                  {
+                     const size_t j = pattern.cols[k];
+                     if (colors[j] == c) {
+                        J.values[k] = (work[i] - f0[i]) / delta_t::delta(x0[j]);
+                     }
+                  }
+               }
+            }
+            t = t0;
+            ++n_jacobians;
+            jacobian_age = 0;
+            jacobian_current = true;
+            c_factored = value_t{};
+         }
+
+         // Factors the preconditioner I - c * J unless it is already factored for c, returns false if it is singular
+         bool factor(const value_t c)
+         {
+            if (c == c_factored) {
+               return true;
+            }
+
+            const auto& pattern = J.pattern;
+            for (size_t i = 0; i < pattern.size(); ++i)
+            {
+               for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+                  M.values[k] = (pattern.cols[k] == i ? 1.0_v : value_t{}) - c * J.values[k];
+               }
+            }
+            if (!lu.factor(M))
+            {
+               c_factored = value_t{};
+               return false;
+            }
+            c_factored = c;
+            return true;
+         }
+
+         // One step from the state in column X0, the solution is left in column Y and its derivatives in FY.
+         // Returns false if the Newton iterations do not converge, e is the error norm if estimated.
+         template <class modules_t>
+         bool step(modules_t& blocks, value_t& t, const value_t t0, const value_t dt, const AdaptiveT<value_t>& settings, const bool estimate, value_t& e)
+         {
+            auto& arena = propagator.arena;
+            auto* x0 = arena.column(X0);
+            auto* f0 = arena.column(F0);
+            auto* f1 = arena.column(F1);
+            auto* f2 = arena.column(F2);
+            auto* base = arena.column(BASE);
+            auto* y = arena.column(Y);
+
+            const value_t c = d * dt;
+            const value_t tol = newton_tolerance(settings);
+            preconditioned = precondition && factor(c);
+
+            // trapezoidal stage, predicted by an Euler step
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i)
+               {
+                  base[i] = x0[i] + c * f0[i];
+                  y[i] = base[i] + c * f0[i];
+               }
+            });
+            if (!newton(blocks, t, t0 + gamma * dt, c, F1, tol)) {
+               return false;
+            }
+
+            // BDF2 stage
+            const value_t w_dt = w * dt;
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i)
+               {
+                  base[i] = x0[i] + w_dt * (f0[i] + f1[i]);
+                  y[i] = base[i] + c * f1[i];
+               }
+            });
+            if (!newton(blocks, t, t0 + dt, c, F2, tol)) {
+               return false;
+            }
+
+            evaluate(blocks, t, t0 + dt, Y, FY); // the derivatives at the solution start the next step
+
+            if (estimate)
+            {
+               auto* r = arena.column(V);
+               for_rows(propagator, [&](const size_t begin, const size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                     r[i] = dt * (e0 * f0[i] + e1 * f1[i] + e2 * f2[i]);
+                  }
+               });
+               gmres(blocks, t, t0 + dt, c, 1.0_v); // filters the estimate through the iteration matrix, to a fraction of the error tolerance
+
+               const auto* err = arena.column(DY);
+               e = error_norm(blocks, propagator, settings, [&](const size_t i) {
+                  return std::abs(err[i]);
+               }, [&](const size_t i) {
+                  return std::max(std::abs(x0[i]), std::abs(y[i]));
+               });
+            }
+            return true;
+         }
+
+         // Sets the states to the solution, whose derivatives start the next step
+         template <class modules_t>
+         void accept(modules_t& blocks, value_t& t, const value_t t1)
+         {
+            auto& arena = propagator.arena;
+            load(Y);
+            t = t1;
+            postprop(blocks);
+
+            auto* f0 = arena.column(F0);
+            const auto* fy = arena.column(FY);
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               std::copy(fy + begin, fy + end, f0 + begin);
+            });
+            fsal_computed = true;
+            ++jacobian_age;
+         }
+
+         // Newton iterations for Y = base + c * f(Y, t_stage), starting from column Y. On convergence the stage derivative, (Y - base) / c, is stored in column F.
+         template <class modules_t>
+         bool newton(modules_t& blocks, value_t& t, const value_t t_stage, const value_t c, const size_t F, const value_t tol)
+         {
+            auto& arena = propagator.arena;
+            auto* base = arena.column(BASE);
+            auto* y = arena.column(Y);
+            const auto* fy = arena.column(FY);
+            const auto* dy = arena.column(DY);
+            auto* r = arena.column(V);
+
+            value_t dy_norm_old{};
+            for (size_t iteration = 0; iteration < max_newton; ++iteration)
+            {
+               evaluate(blocks, t, t_stage, Y, FY);
+               for_rows(propagator, [&](const size_t begin, const size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                     r[i] = base[i] + c * fy[i] - y[i];
+                  }
+               });
+               gmres(blocks, t, t_stage, c, tol);
+               for_rows(propagator, [&](const size_t begin, const size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                     y[i] += dy[i];
+                  }
+               });
+
+               const value_t dy_norm = norm(DY);
+               const value_t rate = iteration > 0 ? dy_norm / dy_norm_old : value_t{};
+               if (iteration > 0 && (rate >= 1.0_v || std::pow(rate, static_cast<value_t>(max_newton - iteration)) / (1.0_v - rate) * dy_norm > tol)) {
+                  return false; // diverging, or too slow to converge in the remaining iterations
+               }
+               if (dy_norm == value_t{} || (iteration > 0 && rate / (1.0_v - rate) * dy_norm < tol))
+               {
+                  auto* f = arena.column(F);
+                  for_rows(propagator, [&](const size_t begin, const size_t end) {
+                     for (size_t i = begin; i < end; ++i) {
+                        f[i] = (y[i] - base[i]) / c;
+                     }
+                  });
+                  return true;
+               }
+               dy_norm_old = dy_norm;
+            }
+            return false;
+         }
+
+         // Solves (I - c * J) DY = V[0] by GMRES in the weighted inner product, J linearized about column Y whose derivatives are in FY.
+         // J v is the directional difference (f(Y + eps * v) - f(Y)) / eps. With a preconditioner P the iterations solve (I - c * J) P^-1 u = V[0], DY = P^-1 u.
+         // Stops once the norm of the residual is below krylov_tol * tol, or has been reduced
+         // by krylov_tol if it starts below tol, or after krylov_dim iterations.
+         template <class modules_t>
+         void gmres(modules_t& blocks, value_t& t, const value_t t_eval, const value_t c, const value_t tol)
+         {
+            auto& arena = propagator.arena;
+            const size_t m = krylov_dim;
+            auto* dy = arena.column(DY);
+            const auto* y = arena.column(Y);
+            const auto* fy = arena.column(FY);
+            auto* work = arena.column(WORK);
+            auto* z = arena.column(Z);
+
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               std::fill(dy + begin, dy + end, value_t{});
+            });
+
+            const value_t beta = std::sqrt(dot(V, V));
+            if (beta == value_t{} || !std::isfinite(beta)) {
+               return;
+            }
+            scale(V, 1.0_v / beta);
+            const value_t target = krylov_tol * std::min(beta, tol * std::sqrt(static_cast<value_t>(arena.size()))); // the weighted 2-norm is sqrt(n) times the root mean square
+
+            H.assign((m + 1) * m, value_t{});
+            cs.assign(m, value_t{});
+            sn.assign(m, value_t{});
+            g.assign(m + 1, value_t{});
+            g[0] = beta;
+
+            const value_t y_norm = std::sqrt(sum_rows(propagator, [&](const size_t begin, const size_t end) {
+               value_t s{};
+               for (size_t i = begin; i < end; ++i) {
+                  s += y[i] * y[i];
+               }
+               return s;
+            }));
+
+            size_t k{};
+            while (k < m)
+            {
+               const auto* v_k = arena.column(V + k);
+               auto* v_next = arena.column(V + k + 1);
+               if (preconditioned)
+               {
+                  std::copy(v_k, v_k + arena.size(), z);
+                  lu.solve(z);
+                  v_k = z;
+               }
+
+               // v_next = (I - c * J) v_k
+               const value_t v_norm = std::sqrt(sum_rows(propagator, [&](const size_t begin, const size_t end) {
+                  value_t s{};
+                  for (size_t i = begin; i < end; ++i) {
+                     s += v_k[i] * v_k[i];
+                  }
+                  return s;
+               }));
+               const value_t eps = std::sqrt(std::numeric_limits<value_t>::epsilon()) * (1.0_v + y_norm) / v_norm;
+               for_rows(propagator, [&](const size_t begin, const size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                     work[i] = y[i] + eps * v_k[i];
+                  }
+               });
+               evaluate(blocks, t, t_eval, WORK, WORK);
+               const value_t c_eps = c / eps;
+               for_rows(propagator, [&](const size_t begin, const size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                     v_next[i] = v_k[i] - c_eps * (work[i] - fy[i]);
+                  }
+               });
+               ++krylov_iterations;
+
+               // modified Gram-Schmidt
+               for (size_t i = 0; i <= k; ++i)
+               {
+                  const value_t h = dot(V + k + 1, V + i);
+                  H[i * m + k] = h;
+                  axpy(V + k + 1, -h, V + i);
+               }
+               const value_t h_next = std::sqrt(dot(V + k + 1, V + k + 1));
+               H[(k + 1) * m + k] = h_next;
+               if (h_next > value_t{}) {
+                  scale(V + k + 1, 1.0_v / h_next);
+               }
+
+               // Givens rotations reduce H to upper triangular form, g[k + 1] is the residual norm
+               for (size_t i = 0; i < k; ++i)
+               {
+                  const value_t a = H[i * m + k];
+                  const value_t b = H[(i + 1) * m + k];
+                  H[i * m + k] = cs[i] * a + sn[i] * b;
+                  H[(i + 1) * m + k] = -sn[i] * a + cs[i] * b;
+               }
+               const value_t a = H[k * m + k];
+               const value_t r = std::hypot(a, h_next);
+               cs[k] = r > value_t{} ? a / r : 1.0_v;
+               sn[k] = r > value_t{} ? h_next / r : value_t{};
+               H[k * m + k] = r;
+               H[(k + 1) * m + k] = value_t{};
+               g[k + 1] = -sn[k] * g[k];
+               g[k] = cs[k] * g[k];
+
+               ++k;
+               if (std::abs(g[k]) <= target || h_next == value_t{}) {
+                  break;
+               }
+            }
+
+            // back substitution for the Krylov coefficients, DY = sum y_i V_i
+            for (size_t i = k; i-- > 0;)
+            {
+               value_t s = g[i];
+               for (size_t j = i + 1; j < k; ++j) {
+                  s -= H[i * m + j] * g[j];
+               }
+               g[i] = H[i * m + i] != value_t{} ? s / H[i * m + i] : value_t{};
+            }
+            for (size_t i = 0; i < k; ++i) {
+               axpy(DY, g[i], V + i);
+            }
+            if (preconditioned) {
+               lu.solve(dy);
+            }
+         }
+
+         // Sets the states to column c, runs the update passes at t_eval and gathers the derivatives into column f
+         template <class modules_t>
+         void evaluate(modules_t& blocks, value_t& t, const value_t t_eval, const size_t c, const size_t f)
+         {
+            auto& arena = propagator.arena;
+            load(c);
+            t = t_eval;
+            postprop(blocks);
+            update(blocks);
+            apply(blocks);
+            ++evaluations;
+
+            auto* xd = arena.column(f);
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i) {
+                  xd[i] = *arena.xd[i];
+               }
+            });
+         }
+
+         void load(const size_t c)
+         {
+            propagator.pass = c;
+            propagate_rows(propagator, 0, propagator.arena.size(), value_t{});
+         }
+
+         // Weighted inner product of two columns
+         value_t dot(const size_t a, const size_t b)
+         {
+            auto& arena = propagator.arena;
+            const auto* u = arena.column(a);
+            const auto* v = arena.column(b);
+            const auto* weight = arena.column(WEIGHT);
+            return sum_rows(propagator, [&](const size_t begin, const size_t end) {
+               value_t s{};
+               for (size_t i = begin; i < end; ++i) {
+                  s += u[i] * v[i] * weight[i] * weight[i];
+               }
+               return s;
+            });
+         }
+
+         // Weighted root mean square norm of a column, below one within the tolerances
+         value_t norm(const size_t a) { return std::sqrt(dot(a, a) / static_cast<value_t>(std::max<size_t>(propagator.arena.size(), 1))); }
+
+         void scale(const size_t a, const value_t s)
+         {
+            auto* u = propagator.arena.column(a);
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i) {
+                  u[i] *= s;
+               }
+            });
+         }
+
+         // column a += s * column b
+         void axpy(const size_t a, const value_t s, const size_t b)
+         {
+            auto* u = propagator.arena.column(a);
+            const auto* v = propagator.arena.column(b);
+            for_rows(propagator, [&](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i) {
+                  u[i] += s * v[i];
+               }
+            });
+         }
+
+         std::vector<value_t> H, cs, sn, g; // Hessenberg matrix (row-major, krylov_dim columns), Givens rotations and the rotated residual
+         bool preconditioned = false; // the factored preconditioner is used for the current step
+      };
+   }
+}
@@ -28,7 +28,7 @@ namespace asc
    namespace modular
    {
       template <class value_t>
-      struct VABMprop : public Propagator<value_t>
+      struct VABMprop : public BatchPropagator<VABMprop<value_t>, value_t>
       {
          VABMprop(size_t order = 4)
          {
@@ -46,13 +46,10 @@ namespace asc
             }
          }
 
-         void calc_phi(State &state, value_t dx, size_t k) {
-            const auto phi_n_a = &state.memory[phi_n_i]; // Array length 4
-            const auto phi_star_n_a = &state.memory[phi_star_n_i]; // Array length 4
-            const auto phi_star_nm1_a = &state.memory[phi_star_nm1_i]; // Array length 4
-            const auto phi_n = [&](size_t i) -> auto &{return *(phi_n_a + i); };
-            const auto phi_star_n = [&](size_t i) -> auto &{return *(phi_star_n_a + i); };
-            const auto phi_star_nm1 = [&](size_t i) -> auto &{return *(phi_star_nm1_a + i); };
+         void calc_phi(const size_t row, value_t dx, size_t k) {
+            const auto phi_n = [&](size_t i) -> auto &{ return this->arena(phi_n_i + i, row); };
+            const auto phi_star_n = [&](size_t i) -> auto &{ return this->arena(phi_star_n_i + i, row); };
+            const auto phi_star_nm1 = [&](size_t i) -> auto &{ return this->arena(phi_star_nm1_i + i, row); };
 
             phi_n(0) = dx;
             phi_star_n(0) = dx;
@@ -62,11 +59,13 @@ namespace asc
             }
          }
 
-         void calc_phi_np1(State &state, value_t dx, size_t k) {
-            const auto phi_star_n_a = &state.memory[phi_star_n_i]; // Array length 4
-            const auto phi_np1_a = &state.memory[phi_np1_i]; // Array length 4
-            const auto phi_star_n = [&](size_t i) -> auto &{return *(phi_star_n_a + i); };
-            const auto phi_np1 = [&](size_t i) -> auto &{return *(phi_np1_a + i); };
+         void calc_phi(State &state, value_t dx, size_t k) {
+            calc_phi(state.index, dx, k);
+         }
+
+         void calc_phi_np1(const size_t row, value_t dx, size_t k) {
+            const auto phi_star_n = [&](size_t i) -> auto &{ return this->arena(phi_star_n_i + i, row); };
+            const auto phi_np1 = [&](size_t i) -> auto &{ return this->arena(phi_np1_i + i, row); };
 
             phi_np1(0) = dx;
             for (size_t i = 1; i < k; ++i) {
@@ -96,48 +95,44 @@ namespace asc
             }
          }
 
-         void swap_phi_star(State &state) {
-            const auto phi_star_n_a = &state.memory[phi_star_n_i]; // Array length k
-            const auto phi_star_nm1_a = &state.memory[phi_star_nm1_i]; // Array length k
+         void swap_phi_star(const size_t row) {
             for (size_t i = 0; i < order; ++i) {
-               std::swap(*(phi_star_n_a + i), *(phi_star_nm1_a + i));
+               std::swap(this->arena(phi_star_n_i + i, row), this->arena(phi_star_nm1_i + i, row));
             }
          }
 
-         void operator()(State &state, const value_t /*dt*/) override
+         void swap_phi_star(State &state) {
+            swap_phi_star(state.index);
+         }
+
+         void batch(const StateSpan<value_t> &s, const size_t pass, const value_t /*dt*/)
          {
-            auto &x = *state.x;
-            auto &xd = *state.xd;
-            if (state.memory.size() < memory_size) {
-               state.memory.resize(memory_size);
-            }
-            auto &x0 = state.memory[x0_i];
-            auto &xd0 = state.memory[xd0_i];
-            auto &xp = state.memory[xp_i];
-            const auto phi_n_a = &state.memory[phi_n_i]; // Array length k
-            const auto phi_star_n_a = &state.memory[phi_star_n_i]; // Array length k
-            const auto phi_star_nm1_a = &state.memory[phi_star_nm1_i]; // Array length k
-            const auto phi_np1_a = &state.memory[phi_np1_i]; // Array length k+1
-            [[maybe_unused]] const auto phi_n = [&](size_t i) -> auto &{return *(phi_n_a + i); };
-            const auto phi_star_n = [&](size_t i) -> auto &{return *(phi_star_n_a + i); };
-            [[maybe_unused]] const auto phi_star_nm1 = [&](size_t i) -> auto &{return *(phi_star_nm1_a + i); };
-            const auto phi_np1 = [&](size_t i) -> auto &{return *(phi_np1_a + i); };
-
-            switch (Propagator<value_t>::pass)
+            const size_t n = s.size();
+            const size_t row0 = s.begin;
+            auto *x0 = s.column(x0_i);
+            auto *xd0 = s.column(xd0_i);
+            auto *xp = s.column(xp_i);
+
+            switch (pass)
             {
             case 0:
-               x0 = x;
-               calc_phi(state, xd, order);
-               for (size_t i = 0; i < order; ++i) {
-                  x += g[i] * phi_star_n(i);
+               for (size_t i = 0; i < n; ++i) {
+                  auto &x = *s.x[i];
+                  x0[i] = x;
+                  calc_phi(row0 + i, *s.xd[i], order);
+                  for (size_t j = 0; j < order; ++j) {
+                     x += g[j] * s.column(phi_star_n_i + j)[i];
+                  }
+                  xd0[i] = *s.xd[i];
+                  xp[i] = x;
                }
-               xd0 = xd;
-               xp = x;
                break;
             case 1:
-               calc_phi_np1(state, xd, order + 1);
-               x += g[order] * phi_np1(order);
-               swap_phi_star(state);
+               for (size_t i = 0; i < n; ++i) {
+                  calc_phi_np1(row0 + i, *s.xd[i], order + 1);
+                  *s.x[i] += g[order] * s.column(phi_np1_i + order)[i];
+                  swap_phi_star(row0 + i);
+               }
                break;
             }
          }
@@ -170,6 +165,7 @@ namespace asc
             phi_star_nm1_i = phi_star_n_i + k;
             phi_np1_i = phi_star_nm1_i + k;
             memory_size = phi_np1_i + k + 1;
+            this->arena.columns(memory_size);
          }
 
          size_t order{};
@@ -198,7 +194,7 @@ namespace asc
       //struct VABM : AdaptiveIntegrator
       struct VABM
       {
-         VABM(size_t order = 4) : order(order), propagator(order) {};
+         VABM(size_t order = 4) : propagator(order), order(order) {};
 
          template <typename modules_t>
          void operator()(modules_t &blocks, value_t &t, const value_t dt)
@@ -210,28 +206,13 @@ namespace asc
                   initializer.run_first = run_first;
                }
 
+               auto &arena = propagator.arena;
+
                // Record full step state history
                if (initialized == 0) {
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block.second->states)
-                        {
-                           state.hist_len = order - 1;
-                        }
-                     }
-                  }
-                  else
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block->states)
-                        {
-                           state.hist_len = order - 1;
-                        }
-                     }
-                  }
+                  arena.sync(blocks);
+                  arena.history(order - 1);
+                  initializer.propagator.history = &arena;
                }
 
                // Run initializer integrator
@@ -242,41 +223,16 @@ namespace asc
                ++initialized;
 
                if (initialized == (order - 1)) {
+                  initializer.propagator.history = nullptr; // We dont need to track the history anymore
                   propagator.calc_beta(order);
 
-                  // calc_phi for past steps and store in the states memory
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block.second->states)
-                        {
-                           if (state.memory.size() < propagator.memory_size) {
-                              state.memory.resize(propagator.memory_size);
-                           }
-                           for (size_t k = 0; k < order - 1; ++k) {
-                              propagator.calc_phi(state, state.xd0_hist[k], k + 1);
-                              propagator.swap_phi_star(state);
-                              state.hist_len = 0; // We dont need to track the history anymore
-                           }
-                        }
-                     }
-                  }
-                  else
+                  // calc_phi for past steps and store it in the arena
+                  const size_t n = arena.size();
+                  for (size_t i = 0; i < n; ++i)
                   {
-                     for (auto &block : blocks)
-                     {
-                        for (auto &state : block->states)
-                        {
-                           if (state.memory.size() < propagator.memory_size) {
-                              state.memory.resize(propagator.memory_size);
-                           }
-                           for (size_t k = 0; k < order - 1; ++k) {
-                              propagator.calc_phi(state, state.xd0_hist[k], k + 1);
-                              propagator.swap_phi_star(state);
-                              state.hist_len = 0; // We dont need to track the history anymore
-                           }
-                        }
+                     for (size_t k = 0; k < order - 1; ++k) {
+                        propagator.calc_phi(i, arena.xd_history(k)[i], k + 1);
+                        propagator.swap_phi_star(i);
                      }
                   }
                }
@@ -311,10 +267,6 @@ namespace asc
          template <class modules_t>
          void operator()(modules_t &blocks, value_t &t, value_t &dt, const AdaptiveT<value_t> &settings)
          {
-            const value_t abs_tol = settings.abs_tol;
-            const value_t rel_tol = settings.rel_tol;
-            [[maybe_unused]] const value_t safety_factor = settings.safety_factor;
-
             const value_t t0 = t;
 
          start_vabm_adaptive:
@@ -325,51 +277,23 @@ namespace asc
                return;
             }
 
-            value_t e_max{};
-            for (auto &block : blocks)
-            {
-               auto solve = [&](auto &state)
-               {
-                  [[maybe_unused]] auto &x = *state.x;
-                  [[maybe_unused]] auto &xd = *state.xd;
-                  auto &x0 = state.memory[propagator.x0_i];
-                  [[maybe_unused]] auto &xd0 = state.memory[propagator.xd0_i];
-                  const auto phi_np1_a = &state.memory[propagator.phi_np1_i];
-                  const auto phi_np1 = [&](size_t i) -> auto &{return *(phi_np1_a + i); };
-
-                  value_t lte = std::abs((propagator.g[order] - propagator.g[order - 1]) * phi_np1(order));
-                  //value_t lte_m1 = std::abs((propagator.g[order - 1] - propagator.g[order - 2]) * phi_np1(order - 1));
-                  //std::cout << lte / lte_m1 << '\n';
-
-                  //value_t e = lte / (abs_tol + rel_tol * (std::abs(x0) + 0.01 * std::abs(xd0)));
-                  value_t e = lte / (abs_tol + rel_tol * (std::abs(x0)));
-                  //value_t e = std::max(lte / abs_tol, lte / (rel_tol * std::abs(x0)));
-
-                  if (e > e_max)
-                  {
-                     e_max = e;
-                  }
-               };
+            auto &arena = propagator.arena;
+            const size_t n = arena.size();
+            const auto* x0 = arena.column(propagator.x0_i);
+            const auto* phi_np1_order = arena.column(propagator.phi_np1_i + order);
+            const value_t g_diff = propagator.g[order] - propagator.g[order - 1];
 
-               if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-               {
-                  for (auto &state : block.second->states)
-                  {
-                     solve(state);
-                  }
-               }
-               else
-               {
-                  for (auto &state : block->states)
-                  {
-                     solve(state);
-                  }
-               }
-            }
+            const value_t e = error_norm(blocks, propagator, settings, [&](const size_t i) {
+               return std::abs(g_diff * phi_np1_order[i]); // local truncation error
+            }, [&](const size_t i) {
+               return std::max(std::abs(x0[i]), std::abs(*arena.x[i]));
+            });
 
-            if (e_max > 1.0)
+            const value_t factor = controller(e, static_cast<value_t>(order + 1), settings.safety_factor);
+
+            if (e > 1.0_v)
             {
-               dt *= std::max(std::pow(2.0 * e_max, -cx(1.0 / (order + 1))), 0.5_v);
+               dt *= factor;
 
                if (run_first) {
                   run_first->base_time_step(dt);
@@ -381,52 +305,38 @@ namespace asc
                   propagator.dt[i] = propagator.dt[i + 1];
                }
 
-               for (auto &block : blocks)
+               for (size_t i = 0; i < n; ++i)
                {
-                  auto solve = [&](auto &state)
-                  {
-                     *state.x = state.memory[propagator.x0_i];
-                     propagator.swap_phi_star(state);
-                  };
-
-                  if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-                  {
-                     for (auto &state : block.second->states)
-                     {
-                        solve(state);
-                     }
-                  }
-                  else
-                  {
-                     for (auto &state : block->states)
-                     {
-                        solve(state);
-                     }
-                  }
+                  *arena.x[i] = x0[i];
+                  propagator.swap_phi_star(i);
                }
 
                goto start_vabm_adaptive; // recompute the solution recursively
             }
 
-            if (e_max < 0.25_v)
-            {
-               e_max = std::max(1e-7, e_max);
-               dt *= std::min(std::pow(2.0 * e_max, -cx(1.0 / (order + 1))), 1.5_v);
+            dt *= factor;
 
-               if (run_first) {
-                  run_first->base_time_step(dt);
-               }
+            if (run_first) {
+               run_first->base_time_step(dt);
             }
          }
 
          asc::Timing<double> *run_first{};
 
+         StepControllerT<value_t> controller = [] {
+            auto controller = StepControllerT<value_t>::PI();
+            controller.min_factor = 0.5_v; // the difference tables are rescaled every step, large changes cost accuracy
+            controller.max_factor = 1.5_v;
+            return controller;
+         }();
+
+         VABMprop<value_t> propagator;
+         VABMstepper<value_t> stepper;
+
       private:
          size_t order{};
          size_t initialized = 0;
          init_integrator initializer;
-         VABMprop<value_t> propagator;
-         VABMstepper<value_t> stepper;
       };
    }
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+
+#include <ostream>
+
+namespace asc
+{
+   // Memory accounting of a modular model.
+   // A State is only a handle (two pointers and an arena row), the integrators keep their stage memory out of line in their arenas.
+   struct MemoryUsage
+   {
+      size_t modules{};
+      size_t states{};
+      size_t module_bytes{}; // module objects, only known for containers that own their modules (ModuleGraph, StaticSystem)
+      size_t state_bytes{}; // storage of Module::states
+      size_t arena_bytes{}; // stage memory, history and gathered pointers of the integrators
+
+      size_t total_bytes() const noexcept { return module_bytes + state_bytes + arena_bytes; }
+
+      double bytes_per_state() const noexcept { return states ? static_cast<double>(total_bytes()) / states : 0.0; }
+
+      MemoryUsage& operator+=(const MemoryUsage& other) noexcept
+      {
+         modules += other.modules;
+         states += other.states;
+         module_bytes += other.module_bytes;
+         state_bytes += other.state_bytes;
+         arena_bytes += other.arena_bytes;
+         return *this;
+      }
+   };
+
+   template <class modules_t>
+   MemoryUsage memory_usage(modules_t& blocks)
+   {
+      MemoryUsage usage;
+      for (auto& block : blocks)
+      {
+         auto& states = deref(block).states;
+         ++usage.modules;
+         usage.states += states.size();
+         usage.state_bytes += states.capacity() * sizeof(State);
+      }
+      if constexpr (requires { blocks.module_bytes(); }) {
+         usage.module_bytes = blocks.module_bytes();
+      }
+      return usage;
+   }
+
+   // Arena memory of an integrator, including the start-up integrator of the multistep methods (ABM4, VABM, PC233) and the members of a switching integrator
+   template <class integrator_t>
+   size_t arena_bytes(const integrator_t& integrator) noexcept
+   {
+      size_t bytes{};
+      if constexpr (requires { integrator.propagator.arena.bytes(); }) {
+         bytes += integrator.propagator.arena.bytes();
+      }
+      if constexpr (requires { integrator.initializer; }) {
+         bytes += arena_bytes(integrator.initializer);
+      }
+      if constexpr (requires { integrator.dopri; integrator.implicit; }) {
+         bytes += arena_bytes(integrator.dopri) + arena_bytes(integrator.implicit);
+      }
+      return bytes;
+   }
+
+   // Includes the arenas of the integrators that propagate the blocks
+   template <class modules_t, class... integrators_t>
+   MemoryUsage memory_usage(modules_t& blocks, const integrators_t&... integrators)
+   {
+      MemoryUsage usage = memory_usage(blocks);
+      ((usage.arena_bytes += arena_bytes(integrators)), ...);
+      return usage;
+   }
+
+   inline std::ostream& operator<<(std::ostream& os, const MemoryUsage& usage)
+   {
+      auto mib = [](const size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+      os << "modules: " << usage.modules << '\n';
+      os << "states: " << usage.states << '\n';
+      os << "module objects [MiB]: " << mib(usage.module_bytes) << '\n';
+      os << "state handles [MiB]: " << mib(usage.state_bytes) << '\n';
+      os << "integrator arenas [MiB]: " << mib(usage.arena_bytes) << '\n';
+      os << "total [MiB]: " << mib(usage.total_bytes()) << '\n';
+      os << "bytes per state: " << usage.bytes_per_state() << '\n';
+      return os;
+   }
+}
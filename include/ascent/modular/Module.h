@@ -1,230 +1,517 @@
-// Copyright (c) 2016-2019 Anyar, Inc.
-// 
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-// 
-//      http://www.apache.org/licenses/LICENSE-2.0
-// 
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#pragma once
-
-#include "ascent/direct/State.h"
-
-namespace asc
-{
-   template <typename T>
-   struct is_pair : std::false_type { };
-
-   template <typename T, typename U>
-   struct is_pair<std::pair<T, U>> : std::true_type { };
-
-   template <typename T>
-   constexpr bool is_pair_v = is_pair<T>::value;
-
-   template <class value_t>
-   struct Propagator
-   {
-      Propagator() = default;
-      Propagator(const Propagator&) = default;
-      Propagator(Propagator&&) = default;
-      Propagator& operator=(const Propagator&) = default;
-      Propagator& operator=(Propagator&&) = default;
-      virtual ~Propagator() {}
-
-      virtual void operator()(State&, const double) = 0; // inputs: state, dt (time step)
-
-      size_t pass{};
-   };
-
-   enum struct Phase
-   {
-      Link,
-      Init,
-      Update,
-      Postprop,
-      Postcalc
-   };
-
-   struct Module
-   {
-      Module() = default;
-      Module(const Module&) = default;
-      Module(Module&&) = default;
-      Module& operator=(const Module&) = default;
-      Module& operator=(Module&&) = default;
-      virtual ~Module() = default;
-
-      std::vector<State> states;
-
-      template <class x_t, class xd_t>
-      void make_state(x_t& x, xd_t& xd)
-      {
-         states.emplace_back(x, xd);
-      }
-
-      template <class x_t, class xd_t>
-      void make_states(x_t& x, xd_t& xd)
-      {
-         const size_t n = x.size();
-         for (size_t i = 0; i < n; ++i)
-         {
-            states.emplace_back(x[i], xd[i]);
-         }
-      }
-
-      template <class data_t>
-      void make_states(data_t* x, data_t* xd, const size_t n)
-      {
-         for (size_t i = 0; i < n; ++i) {
-            states.emplace_back(x[i], xd[i]);
-         }
-      }
-
-      template <class states_t>
-      void add_states(states_t& ext_states)
-      {
-         for (auto& state : states) {
-            ext_states.emplace_back(state);
-         }
-      }
-
-      virtual void link() {} // linking modules
-      virtual void init() {} // initialization
-      virtual void operator()() {} // derivative accumulation
-      virtual void apply() {} // apply accumulations
-      virtual void propagate(Propagator<double>& propagator, const double dt)
-      {
-         for (auto& state : states) {
-            propagator(state, dt);
-         }
-      }
-      virtual void postprop() {} // post propagation calculations (every substep)
-      virtual void postcalc() {} // post integration calculations (every full step)
-
-      bool init_called = false;
-   };
-
-   template <class modules_t>
-   inline void init(modules_t& blocks)
-   {
-      for (auto& block : blocks)
-      {
-         if (!block->init_called)
-         {
-            block->init();
-            block->init_called = true;
-         }   
-      }
-   }
-
-   template <void(Module::* func)(), class modules_t>
-   void call_loop(modules_t& blocks)
-   {
-      if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-      {
-         for (auto& block : blocks) {
-            (block.second->*func)();
-         }
-      }
-      else
-      {
-         for (auto& block : blocks) {
-            (block->*func)();
-         }
-      }
-   }
-
-   template <class modules_t>
-   void update(modules_t& blocks)
-   {
-      call_loop<&Module::operator()>(blocks);
-   }
-
-   template <class modules_t>
-   void update(modules_t& blocks, asc::Module* run_first)
-   {
-      if (run_first) {
-         (*run_first)();
-      }
-      update(blocks);
-   }
-
-   template <class modules_t>
-   void apply(modules_t& blocks)
-   {
-      call_loop<&Module::apply>(blocks);
-   }
-
-   template <class modules_t, class propagator_t, class value_t>
-   void propagate(modules_t& blocks, propagator_t& propagator, const value_t dt)
-   {
-      if constexpr (is_pair_v<typename std::iterator_traits<typename modules_t::iterator>::value_type>)
-      {
-         for (auto& block : blocks) {
-            for (auto &state : block.second->states) {
-               if (propagator.pass == 0 && state.hist_len > 0) {
-                  state.x0_hist.push_back(*state.x);
-                  if (state.x0_hist.size() > state.hist_len) state.x0_hist.pop_front();
-
-                  state.xd0_hist.push_back(*state.xd);
-                  if (state.xd0_hist.size() > state.hist_len) state.x0_hist.pop_front();
-               }
-            }
-            block.second->propagate(propagator, dt);
-         }
-      }
-      else
-      {
-         for (auto& block : blocks) {
-            for (auto &state : block->states) {
-               if (propagator.pass == 0 && state.hist_len > 0) {
-                  state.x0_hist.push_back(*state.x);
-                  if (state.x0_hist.size() > state.hist_len) state.x0_hist.pop_front();
-
-                  state.xd0_hist.push_back(*state.xd);
-                  if (state.xd0_hist.size() > state.hist_len) state.x0_hist.pop_front();
-               }
-            }
-            block->propagate(propagator, dt);
-         }
-      }
-   }
-
-   template <class modules_t>
-   void postprop(modules_t& blocks)
-   {
-      call_loop<&Module::postprop>(blocks);
-   }
-
-   template <class modules_t>
-   inline void postcalc(modules_t& blocks)
-   {
-      call_loop<&Module::postcalc>(blocks);
-   }
-
-   template <class states_t, class ptr_t>
-   inline void add_states(states_t& states, std::vector<ptr_t>& blocks)
-   {
-      for (auto& block : blocks)
-      {
-         auto& m_states = block->states;
-         for (auto& state : m_states) {
-            states.emplace_back(state);
-         }
-      }
-   }
-
-   template <class states_t, class ptr_t>
-   inline void add_states(states_t& states, ptr_t& block)
-   {
-      for (auto& state : block->states) {
-         states.emplace_back(state);
-      }
-   }
+// Copyright (c) 2016-2019 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/direct/State.h"
+#include "ascent/modular/StateArena.h"
+#include "ascent/threading/Pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace asc
+{
+   template <class value_t>
+   struct Propagator
+   {
+      Propagator() = default;
+      Propagator(const size_t n_columns) : arena(n_columns) {}
+      Propagator(const Propagator&) = default;
+      Propagator(Propagator&&) = default;
+      Propagator& operator=(const Propagator&) = default;
+      Propagator& operator=(Propagator&&) = default;
+      virtual ~Propagator() {}
+
+      virtual void operator()(State&, const double) = 0; // inputs: state, dt (time step)
+
+      size_t pass{};
+      StateArena<value_t> arena; // stage memory for every propagated state, owned by the integrator through its propagator
+
+      StateArena<value_t>* history{}; // if set, the states at the start of every step are recorded into the history of this arena
+      Pool* pool{}; // if set, batch propagation and error reductions are split into chunks of rows run on the pool
+      size_t grain = 8192; // minimum rows per chunk, sized so that a chunk's stage memory stays in cache
+   };
+
+   // Base for the built-in propagators. Concrete propagators implement a non-virtual batch(span, pass, dt) over a run of arena rows,
+   // which the engine calls directly so the stage loops can be inlined and vectorized.
+   // The virtual per-state operator() remains for modules that override Module::propagate.
+   template <class derived_t, class value_t>
+   struct BatchPropagator : Propagator<value_t>
+   {
+      BatchPropagator() = default;
+      BatchPropagator(const size_t n_columns) : Propagator<value_t>(n_columns) {}
+
+      void operator()(State& state, const double dt) override
+      {
+         static_cast<derived_t&>(*this).batch(this->arena.span(state.index, state.index + 1), this->pass, dt);
+      }
+   };
+
+   enum struct Phase
+   {
+      Link,
+      Init,
+      Update,
+      Apply,
+      Postprop,
+      Postcalc
+   };
+
+   // Bit of a phase within Module::no_op
+   constexpr uint8_t phase_bit(const Phase phase) noexcept { return static_cast<uint8_t>(1u << static_cast<unsigned>(phase)); }
+
+   struct Module
+   {
+      Module() = default;
+      Module(const Module&) = default;
+      Module(Module&&) = default;
+      Module& operator=(const Module&) = default;
+      Module& operator=(Module&&) = default;
+      virtual ~Module() = default;
+
+      std::vector<State> states;
+
+      template <class x_t, class xd_t>
+      void make_state(x_t& x, xd_t& xd)
+      {
+         states.emplace_back(x, xd);
+      }
+
+      template <class x_t, class xd_t>
+      void make_states(x_t& x, xd_t& xd)
+      {
+         const size_t n = x.size();
+         for (size_t i = 0; i < n; ++i)
+         {
+            states.emplace_back(x[i], xd[i]);
+         }
+      }
+
+      template <class data_t>
+      void make_states(data_t* x, data_t* xd, const size_t n)
+      {
+         for (size_t i = 0; i < n; ++i) {
+            states.emplace_back(x[i], xd[i]);
+         }
+      }
+
+      // Error tolerances of the states for the adaptive integrators, indexed as states. States without an entry use the integrator settings.
+      // Set them before integrating, or invalidate the integrator's arena so they are gathered again.
+      std::vector<Tolerance> tolerances;
+
+      // Sets the error tolerances of every state of this module
+      void tolerance(const double abs_tol, const double rel_tol)
+      {
+         tolerances.assign(states.size(), { abs_tol, rel_tol });
+      }
+
+      // Sets the error tolerances of state i
+      void tolerance(const size_t i, const double abs_tol, const double rel_tol)
+      {
+         if (tolerances.size() <= i) {
+            tolerances.resize(i + 1);
+         }
+         tolerances[i] = { abs_tol, rel_tol };
+      }
+
+      // Excludes state i from error control, its error counts as zero
+      void exclude(const size_t i)
+      {
+         tolerance(i, std::numeric_limits<double>::infinity(), 0.0);
+      }
+
+      template <class states_t>
+      void add_states(states_t& ext_states)
+      {
+         for (auto& state : states) {
+            ext_states.emplace_back(state);
+         }
+      }
+
+      // The default hooks have no work. The engine skips them where it knows the exact type of a module (see overrides_hook),
+      // where the vtable shows them (see keeps_default), or where the module declares them in no_op. Overrides may call these defaults.
+      virtual void link() {} // linking modules
+      virtual void init() {} // initialization
+      virtual void operator()() {} // derivative accumulation
+      virtual void apply() {} // apply accumulations
+      // The engine batch propagates the states of modules known to keep this default, see batch_propagate. Overrides may call it.
+      virtual void propagate(Propagator<double>& propagator, const double dt)
+      {
+         for (auto& state : states) {
+            propagator(state, dt);
+         }
+      }
+      virtual void postprop() {} // post propagation calculations (every substep)
+      virtual void postcalc() {} // post integration calculations (every full step)
+
+      Phase* phase{}; // current phase of the engine that sequences this module through Links, nullptr if Links do not sequence calls
+      bool init_called = false;
+      bool init_run = false;
+      bool update_called = false;
+      bool update_run = false;
+      // The module keeps the default propagate(), so its states are batch propagated. The engine detects the default from the vtable where its
+      // layout is known (see keeps_default) and from the type of the blocks. Elsewhere a Scheduler sets it, or a module declares it up front.
+      bool batch_propagate = false;
+      uint8_t no_op{}; // phase bits of hooks the module declares without work, e.g. no_op = phase_bit(Phase::Apply)
+   };
+
+   // True if T overrides the hook of the given phase. Hooks that cannot be inspected, e.g. overloaded or inaccessible ones, count as overridden.
+   template <class T, Phase phase>
+   constexpr bool overrides_hook() noexcept
+   {
+      using hook_t = void (Module::*)();
+      if constexpr (phase == Phase::Update) {
+         if constexpr (requires { &T::operator(); }) return !std::is_same_v<decltype(&T::operator()), hook_t>;
+         else return true;
+      }
+      else if constexpr (phase == Phase::Apply) {
+         if constexpr (requires { &T::apply; }) return !std::is_same_v<decltype(&T::apply), hook_t>;
+         else return true;
+      }
+      else if constexpr (phase == Phase::Postprop) {
+         if constexpr (requires { &T::postprop; }) return !std::is_same_v<decltype(&T::postprop), hook_t>;
+         else return true;
+      }
+      else if constexpr (phase == Phase::Postcalc) {
+         if constexpr (requires { &T::postcalc; }) return !std::is_same_v<decltype(&T::postcalc), hook_t>;
+         else return true;
+      }
+      else {
+         return true;
+      }
+   }
+
+   // True if T overrides Module::propagate. An inaccessible propagate counts as overridden.
+   template <class T>
+   constexpr bool overrides_propagate() noexcept
+   {
+      if constexpr (requires { &T::propagate; }) return !std::is_same_v<decltype(&T::propagate), void (Module::*)(Propagator<double>&, const double)>;
+      else return true;
+   }
+
+   namespace detail
+   {
+      // The final overrider of a virtual member function of Module in the vtable of a module, nullptr where the vtable layout is unknown.
+      // Itanium C++ ABI (GCC, Clang): a pointer to a virtual member function holds the byte offset of its vtable slot, flagged by a low bit
+      // that ARM keeps in the this adjustment.
+      template <class F>
+      inline const void* final_overrider(const Module& module, F Module::* func) noexcept
+      {
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+         struct { std::ptrdiff_t ptr, adj; } repr;
+         static_assert(sizeof(func) == sizeof(repr));
+         std::memcpy(&repr, &func, sizeof(repr));
+#if defined(__arm__) || defined(__aarch64__)
+         if (!(repr.adj & 1)) return nullptr;
+         const std::ptrdiff_t offset = repr.ptr;
+#else
+         if (!(repr.ptr & 1)) return nullptr;
+         const std::ptrdiff_t offset = repr.ptr - 1;
+#endif
+         const char* vtable = *reinterpret_cast<const char* const*>(&module);
+         return *reinterpret_cast<const void* const*>(vtable + offset);
+#else
+         (void)module;
+         (void)func;
+         return nullptr;
+#endif
+      }
+   }
+
+   // True if the dynamic type of a module keeps the Module default of a virtual member function.
+   // Only known where the vtable layout is (see detail::final_overrider), false elsewhere.
+   template <auto func>
+   inline bool keeps_default(const Module& module) noexcept
+   {
+      static const void* const base = detail::final_overrider(Module{}, func);
+      return base && detail::final_overrider(module, func) == base;
+   }
+
+   // Collects the Link accesses made while the update phase is being discovered.
+   // Each edge reads: the first module accessed the second through a Link, so the second must be updated first.
+   struct LinkTrace
+   {
+      Module* caller{}; // module whose update is currently running
+      std::vector<std::pair<Module*, Module*>> edges;
+   };
+
+   inline thread_local LinkTrace* link_trace{}; // active trace of this thread, if any
+
+   // Makes a trace the active trace of this thread for the scope, the previous one is restored even if the traced pass throws
+   struct ActiveTrace
+   {
+      explicit ActiveTrace(LinkTrace& trace) noexcept : previous(std::exchange(link_trace, &trace)) {}
+      ActiveTrace(const ActiveTrace&) = delete;
+      ActiveTrace& operator=(const ActiveTrace&) = delete;
+      ~ActiveTrace() { link_trace = previous; }
+
+   private:
+      LinkTrace* previous;
+   };
+
+   // Makes a module the caller of a trace while its update runs, the previous caller is restored even if the update throws
+   struct TraceCaller
+   {
+      TraceCaller(LinkTrace& trace, Module* caller) noexcept : trace(trace), previous(std::exchange(trace.caller, caller)) {}
+      TraceCaller(const TraceCaller&) = delete;
+      TraceCaller& operator=(const TraceCaller&) = delete;
+      ~TraceCaller() { trace.caller = previous; }
+
+   private:
+      LinkTrace& trace;
+      Module* previous;
+   };
+
+   template <class modules_t>
+   inline void init(modules_t& blocks)
+   {
+      for (auto& block : blocks)
+      {
+         if (!block->init_run)
+         {
+            block->init_called = true;
+            block->init();
+            block->init_run = true;
+         }   
+      }
+   }
+
+   // True if the dynamic type of a module is its static type T, so the hooks it overrides are known from T
+   template <class T>
+   inline bool exact_type(const T& module) noexcept
+   {
+      if constexpr (std::is_final_v<T>) return true;
+      else return typeid(module) == typeid(T);
+   }
+
+   // Calls the hook of a phase on every module that has work in it. A hook is skipped if the module declares it in no_op,
+   // if the blocks hold a derived type T that keeps the default and the module is exactly a T, or if the vtable shows the default (see keeps_default).
+   template <void(Module::* func)(), Phase phase, class modules_t>
+   void call_loop(modules_t& blocks)
+   {
+      constexpr uint8_t bit = phase_bit(phase);
+      for (auto& block : blocks)
+      {
+         auto& typed = deref(block);
+         using T = std::remove_cvref_t<decltype(typed)>;
+         if constexpr (!std::is_same_v<T, Module> && !overrides_hook<T, phase>())
+         {
+            if (exact_type(typed)) continue;
+         }
+         Module& module = typed;
+         if (!(module.no_op & bit) && !keeps_default<func>(module)) (module.*func)();
+      }
+   }
+
+   template <class modules_t>
+   void update(modules_t& blocks)
+   {
+      call_loop<&Module::operator(), Phase::Update>(blocks);
+   }
+
+   template <class modules_t>
+   void update(modules_t& blocks, asc::Module* run_first)
+   {
+      if (run_first) {
+         (*run_first)();
+      }
+      update(blocks);
+   }
+
+   template <class modules_t>
+   void apply(modules_t& blocks)
+   {
+      call_loop<&Module::apply, Phase::Apply>(blocks);
+   }
+
+   // First pass of a step: numbers the states of the blocks within the arena and records the state history if requested.
+   template <class modules_t, class propagator_t>
+   void prepare_propagation(modules_t& blocks, propagator_t& propagator)
+   {
+      propagator.arena.sync(blocks);
+
+      if (propagator.history) {
+         propagator.history->record();
+      }
+   }
+
+   // Propagates the arena rows [begin, end) through the batch kernel of the propagator, or state by state if it has none.
+   // Batch kernels only touch their own rows, so they are run in parallel chunks if the propagator has a pool.
+   template <class propagator_t, class value_t>
+   void propagate_rows(propagator_t& propagator, const size_t begin, const size_t end, const value_t dt)
+   {
+      if (end <= begin) {
+         return;
+      }
+
+      auto& arena = propagator.arena;
+      if constexpr (requires { propagator.batch(arena.span(begin, end), propagator.pass, dt); })
+      {
+         if (propagator.pool) {
+            propagator.pool->parallel_for(end - begin, propagator.grain, [&](const size_t first, const size_t last) {
+               propagator.batch(arena.span(begin + first, begin + last), propagator.pass, dt);
+            });
+         }
+         else {
+            propagator.batch(arena.span(begin, end), propagator.pass, dt);
+         }
+      }
+      else
+      {
+         for (auto i = begin; i < end; ++i) {
+            State state(*arena.x[i], *arena.xd[i]);
+            state.index = i;
+            propagator(state, dt);
+         }
+      }
+   }
+
+   // Reduces f(begin, end) over blocks of grain arena rows, combined pairwise in a fixed order. The blocks only depend on grain,
+   // so the result is bitwise identical with or without a pool and for any number of threads.
+   template <class propagator_t, class F, class R>
+   auto reduce_rows(propagator_t& propagator, F&& f, R&& reduce)
+   {
+      const size_t n = propagator.arena.size();
+      const size_t grain = std::max<size_t>(propagator.grain, 1);
+      if (n <= grain) {
+         return f(size_t{}, n);
+      }
+
+      using result_t = decltype(f(size_t{}, size_t{}));
+      std::vector<result_t> partial((n + grain - 1) / grain);
+      auto blocks = [&](const size_t first, const size_t last) {
+         for (auto b = first; b < last; ++b) {
+            partial[b] = f(b * grain, std::min(n, (b + 1) * grain));
+         }
+      };
+      if (propagator.pool) {
+         propagator.pool->parallel_for(partial.size(), 1, blocks);
+      }
+      else {
+         blocks(0, partial.size());
+      }
+
+      for (size_t width = 1; width < partial.size(); width *= 2) {
+         for (size_t b = 0; b + width < partial.size(); b += 2 * width) {
+            partial[b] = reduce(partial[b], partial[b + width]);
+         }
+      }
+      return partial.front();
+   }
+
+   // Maximum of f(begin, end) over all arena rows, see reduce_rows. Used for the error norms of the adaptive integrators.
+   template <class propagator_t, class F>
+   auto max_rows(propagator_t& propagator, F&& f)
+   {
+      return reduce_rows(propagator, f, [](const auto a, const auto b) { return std::max(a, b); });
+   }
+
+   // Sum of f(begin, end) over all arena rows, see reduce_rows
+   template <class propagator_t, class F>
+   auto sum_rows(propagator_t& propagator, F&& f)
+   {
+      return reduce_rows(propagator, f, [](const auto a, const auto b) { return a + b; });
+   }
+
+   // Calls f(begin, end) over all arena rows, in parallel chunks if the propagator has a pool.
+   template <class propagator_t, class F>
+   void for_rows(propagator_t& propagator, F&& f)
+   {
+      const size_t n = propagator.arena.size();
+      if (propagator.pool) {
+         propagator.pool->parallel_for(n, propagator.grain, f);
+      }
+      else {
+         f(size_t{}, n);
+      }
+   }
+
+   template <class modules_t, class propagator_t, class value_t>
+   void propagate(modules_t& blocks, propagator_t& propagator, const value_t dt)
+   {
+      if (propagator.pass == 0) {
+         prepare_propagation(blocks, propagator);
+      }
+
+      // Modules with custom propagation are called individually, runs of contiguous rows belonging to default modules are propagated in batches.
+      size_t begin{}, end{};
+      for (auto& block : blocks)
+      {
+         auto& typed = deref(block);
+         using T = std::remove_cvref_t<decltype(typed)>;
+         Module& module = typed;
+         bool batch = module.batch_propagate;
+         if constexpr (!std::is_same_v<T, Module> && !overrides_propagate<T>()) {
+            batch = batch || exact_type(typed);
+         }
+         batch = batch || keeps_default<&Module::propagate>(module);
+
+         if (batch)
+         {
+            if (module.states.empty()) {
+               continue;
+            }
+            const size_t first = module.states.front().index;
+            if (first != end)
+            {
+               propagate_rows(propagator, begin, end, dt);
+               begin = first;
+            }
+            end = first + module.states.size();
+         }
+         else {
+            module.propagate(propagator, dt);
+         }
+      }
+      propagate_rows(propagator, begin, end, dt);
+   }
+
+   template <class modules_t>
+   void postprop(modules_t& blocks)
+   {
+      call_loop<&Module::postprop, Phase::Postprop>(blocks);
+   }
+
+   template <class modules_t>
+   inline void postcalc(modules_t& blocks)
+   {
+      call_loop<&Module::postcalc, Phase::Postcalc>(blocks);
+   }
+
+   template <class states_t, class ptr_t>
+   inline void add_states(states_t& states, std::vector<ptr_t>& blocks)
+   {
+      for (auto& block : blocks)
+      {
+         auto& m_states = block->states;
+         for (auto& state : m_states) {
+            states.emplace_back(state);
+         }
+      }
+   }
+
+   template <class states_t, class ptr_t>
+   inline void add_states(states_t& states, ptr_t& block)
+   {
+      for (auto& state : block->states) {
+         states.emplace_back(state);
+      }
+   }
 }
\ No newline at end of file
@@ -0,0 +1,318 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+#include "ascent/containers/stack.h"
+
+#include <algorithm>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace asc
+{
+   // Stable reference to a module of type T within a ModuleGraph, remains valid as modules are added
+   template <class T>
+   struct Handle
+   {
+      size_t bucket{};
+      size_t index{};
+   };
+
+   // Type erased bucket of modules sharing a concrete type
+   struct ModuleBucket
+   {
+      virtual ~ModuleBucket() = default;
+
+      virtual size_t size() const noexcept = 0;
+      virtual size_t bytes() const noexcept = 0; // storage reserved for the modules
+      virtual Module* module(const size_t i) noexcept = 0;
+      virtual bool custom_propagate() const noexcept = 0;
+
+      virtual void update() = 0;
+      virtual void apply() = 0;
+      virtual void postprop() = 0;
+      virtual void postcalc() = 0;
+
+      size_t row_begin{}; // arena rows of the bucket's states, assigned on the first pass of a step
+      size_t row_end{};
+   };
+
+   // Modules of type T in chunked storage, addresses never change so Links and States remain valid.
+   // Phase loops call the hooks of T directly and are compiled out for hooks T does not override.
+   template <class T>
+   struct Bucket final : ModuleBucket
+   {
+      static constexpr size_t block_size = 256;
+
+      asc::stack<T, block_size> modules;
+
+      size_t size() const noexcept override { return modules.size(); }
+      size_t bytes() const noexcept override { return ((modules.size() + block_size - 1) / block_size) * block_size * sizeof(T); }
+      Module* module(const size_t i) noexcept override { return &modules[i]; }
+
+      bool custom_propagate() const noexcept override
+      {
+         return overrides_propagate<T>();
+      }
+
+      void update() override
+      {
+         if constexpr (overrides_hook<T, Phase::Update>())
+         {
+            if constexpr (requires(T& t) { t.T::operator()(); }) for_each<Phase::Update>([](T& m) { m.T::operator()(); });
+            else for_each<Phase::Update>([](T& m) { m(); }); // inaccessible hooks are called virtually
+         }
+      }
+
+      void apply() override
+      {
+         if constexpr (overrides_hook<T, Phase::Apply>())
+         {
+            if constexpr (requires(T& t) { t.T::apply(); }) for_each<Phase::Apply>([](T& m) { m.T::apply(); });
+            else for_each<Phase::Apply>([](T& m) { m.apply(); }); // inaccessible hooks are called virtually
+         }
+      }
+
+      void postprop() override
+      {
+         if constexpr (overrides_hook<T, Phase::Postprop>())
+         {
+            if constexpr (requires(T& t) { t.T::postprop(); }) for_each<Phase::Postprop>([](T& m) { m.T::postprop(); });
+            else for_each<Phase::Postprop>([](T& m) { m.postprop(); }); // inaccessible hooks are called virtually
+         }
+      }
+
+      void postcalc() override
+      {
+         if constexpr (overrides_hook<T, Phase::Postcalc>())
+         {
+            if constexpr (requires(T& t) { t.T::postcalc(); }) for_each<Phase::Postcalc>([](T& m) { m.T::postcalc(); });
+            else for_each<Phase::Postcalc>([](T& m) { m.postcalc(); }); // inaccessible hooks are called virtually
+         }
+      }
+
+      // Linear sweep over each chunk, skipping modules that declare the hook of the phase in no_op
+      template <Phase phase, class F>
+      void for_each(F&& f)
+      {
+         constexpr uint8_t bit = phase_bit(phase);
+         const size_t n = modules.size();
+         for (size_t s = 0; s * block_size < n; ++s)
+         {
+            T* first = modules.data_slice(s);
+            const size_t n_slice = std::min(block_size, n - s * block_size);
+            for (size_t i = 0; i < n_slice; ++i) {
+               if (!(first[i].no_op & bit)) f(first[i]);
+            }
+         }
+      }
+   };
+
+   // Module storage grouped by concrete type, an ECS style alternative to a std::vector<Module*> for large numbers of identical modules.
+   // Phases sweep each bucket with statically dispatched loops and the states of a bucket occupy contiguous arena rows,
+   // so default propagation is a single batch call per bucket. Iteration yields Module* grouped by bucket, in insertion order within a bucket.
+   struct ModuleGraph
+   {
+      ModuleGraph() = default;
+      ModuleGraph(const ModuleGraph&) = delete;
+      ModuleGraph(ModuleGraph&&) = default;
+      ModuleGraph& operator=(const ModuleGraph&) = delete;
+      ModuleGraph& operator=(ModuleGraph&&) = default;
+
+      using iterator = std::vector<Module*>::iterator;
+
+      template <class T, class... Args>
+      Handle<T> emplace_back(Args&&... args)
+      {
+         static_assert(std::is_base_of_v<Module, T>, "ModuleGraph: T must derive from asc::Module");
+         auto& b = bucket<T>();
+         b.modules.emplace_back(std::forward<Args>(args)...); // in place, states made in the constructor point into the module
+         order.clear();
+         return{ index.at(typeid(T)), b.modules.size() - 1 };
+      }
+
+      template <class T>
+      T& operator[](const Handle<T> handle) noexcept
+      {
+         return static_cast<Bucket<T>&>(*buckets[handle.bucket]).modules[handle.index];
+      }
+
+      // The bucket of T, created if it does not exist
+      template <class T>
+      Bucket<T>& bucket()
+      {
+         auto it = index.find(typeid(T));
+         if (it == index.end())
+         {
+            it = index.emplace(typeid(T), buckets.size()).first;
+            buckets.emplace_back(std::make_unique<Bucket<T>>());
+         }
+         return static_cast<Bucket<T>&>(*buckets[it->second]);
+      }
+
+      size_t n_buckets() const noexcept { return buckets.size(); }
+
+      size_t size() const noexcept
+      {
+         size_t n{};
+         for (auto& b : buckets) {
+            n += b->size();
+         }
+         return n;
+      }
+
+      // Storage reserved for the modules themselves
+      size_t module_bytes() const noexcept
+      {
+         size_t n{};
+         for (auto& b : buckets) {
+            n += b->bytes();
+         }
+         return n;
+      }
+
+      iterator begin() { return modules().begin(); }
+      iterator end() { return modules().end(); }
+
+      void update()
+      {
+         for (auto& b : buckets) {
+            b->update();
+         }
+      }
+
+      void apply()
+      {
+         for (auto& b : buckets) {
+            b->apply();
+         }
+      }
+
+      void postprop()
+      {
+         for (auto& b : buckets) {
+            b->postprop();
+         }
+      }
+
+      void postcalc()
+      {
+         for (auto& b : buckets) {
+            b->postcalc();
+         }
+      }
+
+      template <class propagator_t, class value_t>
+      void propagate(propagator_t& propagator, const value_t dt)
+      {
+         if (propagator.pass == 0)
+         {
+            prepare_propagation(*this, propagator);
+            for (auto& b : buckets) {
+               assign_rows(*b);
+            }
+         }
+
+         for (auto& b : buckets)
+         {
+            if (b->custom_propagate())
+            {
+               const size_t n = b->size();
+               for (size_t i = 0; i < n; ++i) {
+                  b->module(i)->propagate(propagator, dt);
+               }
+            }
+            else {
+               propagate_rows(propagator, b->row_begin, b->row_end, dt);
+            }
+         }
+      }
+
+   private:
+      std::vector<std::unique_ptr<ModuleBucket>> buckets;
+      std::unordered_map<std::type_index, size_t> index;
+      std::vector<Module*> order; // flattened in bucket order, rebuilt when modules are added
+
+      std::vector<Module*>& modules()
+      {
+         if (order.empty())
+         {
+            order.reserve(size());
+            for (auto& b : buckets)
+            {
+               const size_t n = b->size();
+               for (size_t i = 0; i < n; ++i) {
+                  order.emplace_back(b->module(i));
+               }
+            }
+         }
+         return order;
+      }
+
+      // States are numbered in iteration order, so a bucket spans the rows from its first to its last state
+      static void assign_rows(ModuleBucket& b)
+      {
+         b.row_begin = b.row_end = 0;
+         const size_t n = b.size();
+         for (size_t i = 0; i < n; ++i)
+         {
+            auto& states = b.module(i)->states;
+            if (!states.empty())
+            {
+               b.row_begin = states.front().index;
+               break;
+            }
+         }
+         for (size_t i = n; i-- > 0;)
+         {
+            auto& states = b.module(i)->states;
+            if (!states.empty())
+            {
+               b.row_end = states.back().index + 1;
+               break;
+            }
+         }
+      }
+   };
+
+   inline void update(ModuleGraph& graph)
+   {
+      graph.update();
+   }
+
+   inline void apply(ModuleGraph& graph)
+   {
+      graph.apply();
+   }
+
+   template <class propagator_t, class value_t>
+   void propagate(ModuleGraph& graph, propagator_t& propagator, const value_t dt)
+   {
+      graph.propagate(propagator, dt);
+   }
+
+   inline void postprop(ModuleGraph& graph)
+   {
+      graph.postprop();
+   }
+
+   inline void postcalc(ModuleGraph& graph)
+   {
+      graph.postcalc();
+   }
+}
@@ -0,0 +1,402 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Link.h"
+#include "ascent/threading/Pool.h"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace asc
+{
+   // A module container that runs the update phase in parallel.
+   // The first update is a serial discovery pass in which Links sequence the calls, also with ASCENT_NO_LINK_CHECKS, and record which modules access which.
+   // The recorded dependency graph is then compiled into a schedule: flat arrays of direct calls for every phase, with the update calls grouped into levels.
+   // A module only depends on modules of lower levels, so each level is updated concurrently on the pool.
+   // Module::operator() may only write to its own module (accumulations into other modules belong in apply()), which makes results independent of the thread count.
+   // The remaining phases run serially in insertion order, so a Scheduler is a drop-in replacement for a std::vector<Module*> in the modular integrators.
+   // The schedule is only recompiled when modules are added or removed, or when invalidate() is called.
+   struct Scheduler
+   {
+      Scheduler() = default;
+      Scheduler(Pool& pool) : pool(&pool) {}
+      Scheduler(const Scheduler&) = delete;
+      Scheduler(Scheduler&&) = default;
+      Scheduler& operator=(const Scheduler&) = delete;
+      Scheduler& operator=(Scheduler&&) = default;
+
+      using iterator = std::vector<Module*>::iterator;
+      using const_iterator = std::vector<Module*>::const_iterator;
+
+      // A compiled call of a module hook
+      struct Call
+      {
+         void (*func)(Module*){};
+         Module* module{};
+
+         void operator()() const { func(module); }
+      };
+
+      Pool* pool{}; // updates run serially by level without a pool
+      size_t grain = 64; // minimum number of modules handed to a single task
+
+      // The module type is captured so that the compiled schedule calls its hooks directly rather than through the vtable,
+      // and only lists the module in the phases whose hooks T overrides. A module that keeps the default propagate() is marked for batch propagation.
+      // Hooks are called virtually if the module's dynamic type differs from T, they are then listed unless the dynamic type keeps the default
+      // (see keeps_default) or the module declares them in Module::no_op.
+      template <class T>
+      void emplace_back(T* module)
+      {
+         static_assert(std::is_base_of_v<Module, T>, "Scheduler: T must derive from asc::Module");
+         modules.emplace_back(module);
+         if constexpr (!std::is_same_v<T, Module>)
+         {
+            if (typeid(*module) == typeid(T))
+            {
+               if constexpr (!overrides_propagate<T>()) {
+                  module->batch_propagate = true;
+               }
+               hooks.emplace_back(Hooks{ hook<T, Phase::Update>(&call_update<T>), hook<T, Phase::Apply>(&call_apply<T>),
+                  hook<T, Phase::Postprop>(&call_postprop<T>), hook<T, Phase::Postcalc>(&call_postcalc<T>) });
+               invalidate();
+               return;
+            }
+         }
+         hooks.emplace_back(Hooks{ virtual_hook<&Module::operator()>(*module, &call_update<Module>), virtual_hook<&Module::apply>(*module, &call_apply<Module>),
+            virtual_hook<&Module::postprop>(*module, &call_postprop<Module>), virtual_hook<&Module::postcalc>(*module, &call_postcalc<Module>) });
+         invalidate();
+      }
+
+      void erase(Module* module)
+      {
+         for (size_t i = modules.size(); i-- > 0;)
+         {
+            if (modules[i] == module)
+            {
+               modules.erase(modules.begin() + i);
+               hooks.erase(hooks.begin() + i);
+            }
+         }
+         invalidate();
+      }
+
+      // Forces rediscovery of the dependency graph on the next update, e.g. after Links have been reassigned.
+      void invalidate() noexcept { compiled = false; }
+
+      bool discovered() const noexcept { return compiled; }
+
+      iterator begin() noexcept { return modules.begin(); }
+      iterator end() noexcept { return modules.end(); }
+      const_iterator begin() const noexcept { return modules.begin(); }
+      const_iterator end() const noexcept { return modules.end(); }
+      size_t size() const noexcept { return modules.size(); }
+
+      size_t n_levels() const noexcept { return level_offsets.empty() ? 0 : level_offsets.size() - 1; }
+
+      // Number of compiled calls of a phase, i.e. the modules with work in it
+      size_t n_calls(const Phase phase) const noexcept
+      {
+         switch (phase)
+         {
+         case Phase::Update: return update_calls.size();
+         case Phase::Apply: return apply_calls.size();
+         case Phase::Postprop: return postprop_calls.size();
+         case Phase::Postcalc: return postcalc_calls.size();
+         default: return 0;
+         }
+      }
+
+      // Compiled update calls of level k, in insertion order
+      std::span<const Call> level(const size_t k) const noexcept
+      {
+         return{ update_calls.data() + level_offsets[k], level_offsets[k + 1] - level_offsets[k] };
+      }
+
+      void update()
+      {
+         if (!compiled)
+         {
+            discover(); // the discovery pass is sequenced through the Links and serves as this update
+            return;
+         }
+         run_update();
+      }
+
+      void apply() const
+      {
+         for (auto& call : apply_calls) {
+            call();
+         }
+      }
+
+      void postprop() const
+      {
+         for (auto& call : postprop_calls) {
+            call();
+         }
+      }
+
+      void postcalc() const
+      {
+         for (auto& call : postcalc_calls) {
+            call();
+         }
+      }
+
+   private:
+      struct Hooks
+      {
+         void (*update)(Module*);
+         void (*apply)(Module*);
+         void (*postprop)(Module*);
+         void (*postcalc)(Module*);
+      };
+
+      // The hook of a phase, nullptr if T keeps the no-op default
+      template <class T, Phase phase>
+      static constexpr void (*hook(void (*call)(Module*)))(Module*)
+      {
+         if constexpr (overrides_hook<T, phase>()) return call;
+         else return nullptr;
+      }
+
+      // The virtual hook of a module, nullptr if its dynamic type keeps the no-op default
+      template <auto func>
+      static void (*virtual_hook(const Module& module, void (*call)(Module*)))(Module*)
+      {
+         return keeps_default<func>(module) ? nullptr : call;
+      }
+
+      // Qualified calls are not virtual, T = Module dispatches through the vtable
+      template <class T>
+      static void call_update(Module* module)
+      {
+         if constexpr (!std::is_same_v<T, Module> && requires(T& t) { t.T::operator()(); }) static_cast<T*>(module)->T::operator()();
+         else if (!(module->no_op & phase_bit(Phase::Update))) (*module)();
+      }
+
+      template <class T>
+      static void call_apply(Module* module)
+      {
+         if constexpr (!std::is_same_v<T, Module> && requires(T& t) { t.T::apply(); }) static_cast<T*>(module)->T::apply();
+         else if (!(module->no_op & phase_bit(Phase::Apply))) module->apply();
+      }
+
+      template <class T>
+      static void call_postprop(Module* module)
+      {
+         if constexpr (!std::is_same_v<T, Module> && requires(T& t) { t.T::postprop(); }) static_cast<T*>(module)->T::postprop();
+         else if (!(module->no_op & phase_bit(Phase::Postprop))) module->postprop();
+      }
+
+      template <class T>
+      static void call_postcalc(Module* module)
+      {
+         if constexpr (!std::is_same_v<T, Module> && requires(T& t) { t.T::postcalc(); }) static_cast<T*>(module)->T::postcalc();
+         else if (!(module->no_op & phase_bit(Phase::Postcalc))) module->postcalc();
+      }
+
+      std::vector<Module*> modules;
+      std::vector<Hooks> hooks; // hooks of modules[i]
+      bool compiled = false;
+
+      std::vector<Call> update_calls; // grouped by level
+      std::vector<size_t> level_offsets; // level k spans update_calls[level_offsets[k], level_offsets[k + 1])
+      std::vector<Call> apply_calls;
+      std::vector<Call> postprop_calls;
+      std::vector<Call> postcalc_calls;
+      Phase phase = Phase::Update;
+
+      // Only hooks with work are listed: the type did not reveal a no-op and the module has not declared it in no_op
+      bool has_work(const size_t i, void (*func)(Module*), const Phase phase) const noexcept
+      {
+         return func && !(modules[i]->no_op & phase_bit(phase));
+      }
+
+      void run_update()
+      {
+         const size_t n_levels = this->n_levels();
+         for (size_t k = 0; k < n_levels; ++k)
+         {
+            const Call* calls = update_calls.data() + level_offsets[k];
+            const size_t n = level_offsets[k + 1] - level_offsets[k];
+            auto run = [calls](const size_t begin, const size_t end) {
+               for (size_t i = begin; i < end; ++i) {
+                  calls[i]();
+               }
+            };
+
+            if (pool) {
+               pool->parallel_for(n, grain, run);
+            }
+            else {
+               run(0, n);
+            }
+         }
+      }
+
+      // Performs a serial update with Link sequencing enabled and compiles the schedule from the recorded accesses.
+      void discover()
+      {
+         LinkTrace trace;
+         LinkTrace* previous = std::exchange(link_trace, &trace);
+
+         // Integration only starts after initialization, so Links must not initialize the modules again.
+         // Modules without update work count as updated, neither this pass nor their Links call them.
+         for (size_t i = 0; i < modules.size(); ++i)
+         {
+            auto* module = modules[i];
+            module->phase = &phase;
+            module->init_called = true;
+            module->init_run = true;
+            module->update_called = false;
+            module->update_run = !has_work(i, hooks[i].update, Phase::Update);
+         }
+
+         auto release = [&] {
+            link_trace = previous;
+            for (auto* module : modules) {
+               module->phase = nullptr;
+            }
+         };
+
+         try
+         {
+            for (size_t i = 0; i < modules.size(); ++i)
+            {
+               auto* module = modules[i];
+               if (!module->update_run)
+               {
+                  module->update_called = true;
+                  trace.caller = module;
+                  hooks[i].update(module);
+                  module->update_run = true;
+               }
+            }
+         }
+         catch (...)
+         {
+            release();
+            throw;
+         }
+         release();
+
+         compile(trace.edges);
+      }
+
+      void compile(std::vector<std::pair<Module*, Module*>>& edges)
+      {
+         const size_t n = modules.size();
+         std::unordered_map<Module*, size_t> index;
+         index.reserve(n);
+         for (size_t i = 0; i < n; ++i) {
+            index.emplace(modules[i], i);
+         }
+
+         // Kahn's algorithm, accesses to modules outside of this container do not constrain the schedule
+         std::vector<std::vector<size_t>> dependents(n);
+         std::vector<size_t> n_dependencies(n);
+         std::sort(edges.begin(), edges.end());
+         edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+         for (auto& [caller, callee] : edges)
+         {
+            auto from = index.find(callee);
+            auto to = index.find(caller);
+            if (from == index.end() || to == index.end() || from == to) {
+               continue;
+            }
+            dependents[from->second].emplace_back(to->second);
+            ++n_dependencies[to->second];
+         }
+
+         std::vector<size_t> level(n), ready;
+         for (size_t i = 0; i < n; ++i) {
+            if (n_dependencies[i] == 0) ready.emplace_back(i);
+         }
+         size_t n_levels{}, n_visited{};
+         while (!ready.empty())
+         {
+            const size_t i = ready.back();
+            ready.pop_back();
+            ++n_visited;
+            n_levels = std::max(n_levels, level[i] + 1);
+            for (auto j : dependents[i])
+            {
+               level[j] = std::max(level[j], level[i] + 1);
+               if (--n_dependencies[j] == 0) ready.emplace_back(j);
+            }
+         }
+         if (n_visited != n) {
+            throw std::runtime_error("Scheduler: circular Link dependency in the update phase");
+         }
+
+
+         // Counting sort by level keeps insertion order within a level
+         level_offsets.assign(n_levels + 1, 0);
+         for (size_t i = 0; i < n; ++i) {
+            if (has_work(i, hooks[i].update, Phase::Update)) ++level_offsets[level[i] + 1];
+         }
+         for (size_t k = 0; k < n_levels; ++k) {
+            level_offsets[k + 1] += level_offsets[k];
+         }
+         update_calls.resize(level_offsets.back());
+         std::vector<size_t> next(level_offsets.begin(), level_offsets.end() - 1);
+         for (size_t i = 0; i < n; ++i) {
+            if (has_work(i, hooks[i].update, Phase::Update)) update_calls[next[level[i]]++] = { hooks[i].update, modules[i] };
+         }
+
+         apply_calls.clear();
+         postprop_calls.clear();
+         postcalc_calls.clear();
+         for (size_t i = 0; i < n; ++i)
+         {
+            if (has_work(i, hooks[i].apply, Phase::Apply)) apply_calls.push_back({ hooks[i].apply, modules[i] });
+            if (has_work(i, hooks[i].postprop, Phase::Postprop)) postprop_calls.push_back({ hooks[i].postprop, modules[i] });
+            if (has_work(i, hooks[i].postcalc, Phase::Postcalc)) postcalc_calls.push_back({ hooks[i].postcalc, modules[i] });
+         }
+
+         compiled = true;
+      }
+   };
+
+   inline void update(Scheduler& scheduler)
+   {
+      scheduler.update();
+   }
+
+   // The other phases run the compiled schedule once it exists, and in insertion order before the first update.
+   inline void apply(Scheduler& scheduler)
+   {
+      if (scheduler.discovered()) scheduler.apply();
+      else call_loop<&Module::apply, Phase::Apply>(scheduler);
+   }
+
+   inline void postprop(Scheduler& scheduler)
+   {
+      if (scheduler.discovered()) scheduler.postprop();
+      else call_loop<&Module::postprop, Phase::Postprop>(scheduler);
+   }
+
+   inline void postcalc(Scheduler& scheduler)
+   {
+      if (scheduler.discovered()) scheduler.postcalc();
+      else call_loop<&Module::postcalc, Phase::Postcalc>(scheduler);
+   }
+}
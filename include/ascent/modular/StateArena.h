@@ -0,0 +1,265 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+#include "ascent/direct/State.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace asc
+{
+   // A contiguous run of arena rows handed to a batch propagator.
+   template <class value_t>
+   struct StateSpan
+   {
+      value_t* const* x{}; // state pointers of the run
+      value_t* const* xd{}; // derivative pointers of the run
+      value_t* memory{}; // first row of the run within column 0
+      size_t stride{}; // distance between columns
+      size_t begin{}; // arena row of the first state in the run
+      size_t n{};
+
+      size_t size() const noexcept { return n; }
+
+      value_t* column(const size_t c) const noexcept { return memory + c * stride; }
+   };
+
+   // Contiguous stage memory for the modular integrators.
+   // Storage is column-major: column c holds one stage slot (x0, xd0, xd1, ...) for every state, so a propagation pass is a linear sweep.
+   // States are numbered in block order and State::index refers to a row of the arena that last synchronized the state.
+   // Integrators that share states (a multistep integrator and its start up integrator, the members of AutoSwitch, or two integrators
+   // stepping overlapping block sets) renumber them on sync, the stage memory of each arena is kept by state pointer.
+   template <class value_t>
+   struct StateArena
+   {
+      StateArena() = default;
+      StateArena(const size_t n_columns) : n_columns(n_columns) {}
+      StateArena(const StateArena&) = default;
+      StateArena(StateArena&&) = default;
+      StateArena& operator=(const StateArena&) = default;
+      StateArena& operator=(StateArena&&) = default;
+
+      std::vector<value_t*> x; // gathered state pointers, indexed by State::index
+      std::vector<value_t*> xd; // gathered derivative pointers, indexed by State::index
+
+      std::vector<value_t> abs_tol; // per row error tolerances gathered by tolerances(), empty if no module sets its own
+      std::vector<value_t> rel_tol;
+
+      size_t size() const noexcept { return x.size(); }
+
+      size_t columns() const noexcept { return n_columns; }
+
+      void columns(const size_t n)
+      {
+         n_columns = n;
+         data.resize(n_columns * n_rows);
+      }
+
+      value_t* column(const size_t c) noexcept { return data.data() + c * n_rows; }
+      const value_t* column(const size_t c) const noexcept { return data.data() + c * n_rows; }
+
+      value_t& operator()(const size_t c, const size_t i) noexcept { return data[c * n_rows + i]; }
+      const value_t& operator()(const size_t c, const size_t i) const noexcept { return data[c * n_rows + i]; }
+
+      // Rows [begin, end) as a span for batch propagation.
+      StateSpan<value_t> span(const size_t begin, const size_t end) noexcept
+      {
+         return{ x.data() + begin, xd.data() + begin, data.data() + begin, n_rows, begin, end - begin };
+      }
+
+      // Numbers the states of the given blocks and gathers their pointers.
+      // The arena is rebuilt whenever a state is not at its row, e.g. because modules were added, removed or replaced or another set of blocks
+      // is stepped, in which case existing stage memory follows its state to the new row. The previous row is found through State::index
+      // if it still refers to this arena, otherwise by the state pointer, as another arena may have numbered the state since. Returns true if the arena was rebuilt.
+      template <class modules_t>
+      bool sync(modules_t& blocks)
+      {
+         size_t n{};
+         bool current = !stale;
+         for (auto& block : blocks)
+         {
+            for (auto& state : deref(block).states)
+            {
+               current = current && state.index < x.size() && x[state.index] == state.x && xd[state.index] == state.xd;
+               ++n;
+            }
+         }
+
+         if (current && n == x.size()) {
+            return false;
+         }
+         stale = false;
+
+         std::vector<value_t> previous(n_columns * n);
+         std::swap(previous, data);
+         std::vector<value_t> previous_hist(2 * hist_capacity * n);
+         std::swap(previous_hist, hist);
+         const size_t n_previous = n_rows;
+         n_rows = n;
+
+         std::vector<value_t*> previous_x;
+         std::swap(previous_x, x);
+         xd.clear();
+         x.reserve(n);
+         xd.reserve(n);
+
+         std::unordered_map<const value_t*, size_t> previous_rows; // only built if a state was numbered by another arena
+         auto previous_row = [&](const State& state) -> size_t
+         {
+            if (state.index < previous_x.size() && previous_x[state.index] == state.x) {
+               return state.index;
+            }
+            if (previous_rows.empty())
+            {
+               previous_rows.reserve(previous_x.size());
+               for (size_t r = 0; r < previous_x.size(); ++r) {
+                  previous_rows.emplace(previous_x[r], r);
+               }
+            }
+            const auto it = previous_rows.find(state.x);
+            return it == previous_rows.end() ? State::npos : it->second;
+         };
+
+         size_t i{};
+         for (auto& block : blocks)
+         {
+            for (auto& state : deref(block).states)
+            {
+               const size_t row = previous_row(state);
+               if (row != State::npos)
+               {
+                  for (size_t c = 0; c < n_columns; ++c) {
+                     data[c * n_rows + i] = previous[c * n_previous + row];
+                  }
+                  for (size_t c = 0; c < 2 * hist_capacity; ++c) {
+                     hist[c * n_rows + i] = previous_hist[c * n_previous + row];
+                  }
+               }
+               state.index = i++;
+               x.emplace_back(state.x);
+               xd.emplace_back(state.xd);
+            }
+         }
+         ++revision;
+         return true;
+      }
+
+      // Gathers the per row error tolerances of the blocks' states, states without their own use the given defaults.
+      // Only gathered again once the arena has been rebuilt or the defaults change.
+      template <class modules_t>
+      void tolerances(modules_t& blocks, const value_t abs_default, const value_t rel_default)
+      {
+         if (tol_revision == revision && abs_default == tol_defaults[0] && rel_default == tol_defaults[1]) {
+            return;
+         }
+         tol_revision = revision;
+         tol_defaults[0] = abs_default;
+         tol_defaults[1] = rel_default;
+
+         abs_tol.clear();
+         rel_tol.clear();
+         for (auto& block : blocks)
+         {
+            auto& module = deref(block);
+            const size_t n = std::min(module.tolerances.size(), module.states.size());
+            for (size_t j = 0; j < n; ++j)
+            {
+               const auto& tol = module.tolerances[j];
+               const size_t i = module.states[j].index;
+               if (i >= n_rows) {
+                  continue;
+               }
+               if (abs_tol.empty())
+               {
+                  abs_tol.assign(n_rows, abs_default);
+                  rel_tol.assign(n_rows, rel_default);
+               }
+               abs_tol[i] = tol.abs_tol < 0.0 ? abs_default : static_cast<value_t>(tol.abs_tol);
+               rel_tol[i] = tol.rel_tol < 0.0 ? rel_default : static_cast<value_t>(tol.rel_tol);
+            }
+         }
+      }
+
+      // State history: a ring buffer of the states and derivatives at the start of the most recent steps, e.g. for multistep start up.
+      // The buffer is allocated once here, recording only copies into it.
+      void history(const size_t capacity)
+      {
+         hist_capacity = capacity;
+         hist.assign(2 * hist_capacity * n_rows, value_t{});
+         clear_history();
+      }
+
+      size_t history_capacity() const noexcept { return hist_capacity; }
+      size_t history_size() const noexcept { return hist_count; }
+
+      void clear_history() noexcept
+      {
+         hist_head = 0;
+         hist_count = 0;
+      }
+
+      // Records the current states and derivatives, overwriting the oldest entry once the buffer is full
+      void record() noexcept
+      {
+         if (hist_capacity == 0) {
+            return;
+         }
+
+         value_t* hx = hist.data() + 2 * hist_head * n_rows;
+         value_t* hxd = hx + n_rows;
+         for (size_t i = 0; i < n_rows; ++i)
+         {
+            hx[i] = *x[i];
+            hxd[i] = *xd[i];
+         }
+         hist_head = (hist_head + 1) % hist_capacity;
+         hist_count = std::min(hist_count + 1, hist_capacity);
+      }
+
+      // States of the k-th recorded step, k = 0 is the oldest entry
+      value_t* x_history(const size_t k) noexcept { return hist.data() + 2 * slot(k) * n_rows; }
+      // Derivatives of the k-th recorded step, k = 0 is the oldest entry
+      value_t* xd_history(const size_t k) noexcept { return hist.data() + (2 * slot(k) + 1) * n_rows; }
+
+      // Heap memory held by the arena: stage memory, history and gathered pointers
+      size_t bytes() const noexcept
+      {
+         return (data.capacity() + hist.capacity()) * sizeof(value_t) + (x.capacity() + xd.capacity()) * sizeof(value_t*);
+      }
+
+      // Forces the next sync to renumber the states
+      void invalidate() noexcept { stale = true; }
+
+   private:
+      bool stale = false;
+      size_t revision{}; // incremented whenever the rows are renumbered
+      size_t tol_revision = static_cast<size_t>(-1);
+      value_t tol_defaults[2]{};
+
+      size_t n_columns{};
+      size_t n_rows{};
+      std::vector<value_t> data;
+
+      size_t hist_capacity{};
+      size_t hist_head{}; // slot of the next record
+      size_t hist_count{};
+      std::vector<value_t> hist; // 2 * hist_capacity columns, the states and derivatives of each slot
+
+      size_t slot(const size_t k) const noexcept { return (hist_head + hist_capacity - hist_count + k) % hist_capacity; }
+   };
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/modular/Module.h"
+
+#include <array>
+#include <tuple>
+#include <utility>
+
+namespace asc
+{
+   // A system of modules whose composition is fixed at compile time.
+   // Modules are held by value in a std::tuple and every phase is a fold expression over direct (non-virtual) calls,
+   // so the compiler can inline the whole derivative pass. Modules keep the asc::Module programming model: states, Links and hooks work unchanged.
+   // Iteration yields Module* in tuple order, so a StaticSystem can be handed to any modular integrator.
+   template <class... Ms>
+   struct StaticSystem
+   {
+      static_assert((std::is_base_of_v<Module, Ms> && ...), "StaticSystem: modules must derive from asc::Module");
+
+      StaticSystem() = default;
+      StaticSystem(Ms... ms) : modules(std::move(ms)...) {}
+      // States and Links refer to the modules by address
+      StaticSystem(const StaticSystem&) = delete;
+      StaticSystem(StaticSystem&&) = delete;
+      StaticSystem& operator=(const StaticSystem&) = delete;
+      StaticSystem& operator=(StaticSystem&&) = delete;
+
+      static constexpr size_t size() noexcept { return sizeof...(Ms); }
+      static constexpr size_t module_bytes() noexcept { return sizeof(std::tuple<Ms...>); }
+
+      using iterator = typename std::array<Module*, sizeof...(Ms)>::iterator;
+
+      std::tuple<Ms...> modules;
+
+      template <size_t I>
+      auto& get() noexcept { return std::get<I>(modules); }
+
+      template <class M>
+      M& get() noexcept { return std::get<M>(modules); }
+
+      iterator begin() noexcept { return pointers.begin(); }
+      iterator end() noexcept { return pointers.end(); }
+
+      void init()
+      {
+         for_each([](auto& m) {
+            if (!m.init_run)
+            {
+               m.init_called = true;
+               m.init();
+               m.init_run = true;
+            }
+         });
+      }
+
+      void update()
+      {
+         for_each([](auto& m) {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (overrides_hook<M, Phase::Update>())
+            {
+               if constexpr (requires { m.M::operator()(); }) m.M::operator()();
+               else m(); // inaccessible hooks are called virtually
+            }
+         });
+      }
+
+      void apply()
+      {
+         for_each([](auto& m) {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (overrides_hook<M, Phase::Apply>())
+            {
+               if constexpr (requires { m.M::apply(); }) m.M::apply();
+               else m.apply(); // inaccessible hooks are called virtually
+            }
+         });
+      }
+
+      void postprop()
+      {
+         for_each([](auto& m) {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (overrides_hook<M, Phase::Postprop>())
+            {
+               if constexpr (requires { m.M::postprop(); }) m.M::postprop();
+               else m.postprop(); // inaccessible hooks are called virtually
+            }
+         });
+      }
+
+      void postcalc()
+      {
+         for_each([](auto& m) {
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (overrides_hook<M, Phase::Postcalc>())
+            {
+               if constexpr (requires { m.M::postcalc(); }) m.M::postcalc();
+               else m.postcalc(); // inaccessible hooks are called virtually
+            }
+         });
+      }
+
+      // States are numbered in tuple order, so modules with default propagation are batched in contiguous runs
+      template <class propagator_t, class value_t>
+      void propagate(propagator_t& propagator, const value_t dt)
+      {
+         if (propagator.pass == 0) {
+            prepare_propagation(*this, propagator);
+         }
+
+         if constexpr (!(custom_propagate<Ms>() || ...))
+         {
+            propagate_rows(propagator, 0, propagator.arena.size(), dt);
+         }
+         else
+         {
+            size_t begin{}, end{};
+            for_each([&](auto& m) {
+               using M = std::decay_t<decltype(m)>;
+               if constexpr (custom_propagate<M>())
+               {
+                  propagate_rows(propagator, begin, end, dt);
+                  begin = end = end + m.states.size();
+                  m.propagate(propagator, dt);
+               }
+               else {
+                  end += m.states.size();
+               }
+            });
+            propagate_rows(propagator, begin, end, dt);
+         }
+      }
+
+      template <class F>
+      void for_each(F&& f)
+      {
+         std::apply([&](auto&... m) { (f(m), ...); }, modules);
+      }
+
+   private:
+      std::array<Module*, sizeof...(Ms)> pointers = std::apply([](auto&... m) { return std::array<Module*, sizeof...(Ms)>{ &m... }; }, modules);
+
+      template <class M>
+      static constexpr bool custom_propagate() noexcept
+      {
+         return overrides_propagate<M>();
+      }
+   };
+
+   template <class... Ms>
+   void init(StaticSystem<Ms...>& system)
+   {
+      system.init();
+   }
+
+   template <class... Ms>
+   void update(StaticSystem<Ms...>& system)
+   {
+      system.update();
+   }
+
+   template <class... Ms>
+   void apply(StaticSystem<Ms...>& system)
+   {
+      system.apply();
+   }
+
+   template <class... Ms, class propagator_t, class value_t>
+   void propagate(StaticSystem<Ms...>& system, propagator_t& propagator, const value_t dt)
+   {
+      system.propagate(propagator, dt);
+   }
+
+   template <class... Ms>
+   void postprop(StaticSystem<Ms...>& system)
+   {
+      system.postprop();
+   }
+
+   template <class... Ms>
+   void postcalc(StaticSystem<Ms...>& system)
+   {
+      system.postcalc();
+   }
+}
@@ -0,0 +1,507 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Utility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ASCENT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ASCENT_ALWAYS_INLINE [[gnu::always_inline]] inline
+#else
+#define ASCENT_ALWAYS_INLINE inline
+#endif
+
+// Explicitly vectorized stage combination kernels for the direct integrators.
+// On x86-64 the instruction set (SSE2, AVX2 + FMA, AVX-512) is selected at runtime, other targets use the scalar kernels.
+// Kernels operate on contiguous double states, any other state_t (std::deque, std::array...) takes a plain element-wise loop.
+
+namespace asc
+{
+   namespace simd
+   {
+      enum struct Isa { Scalar, SSE2, AVX2, AVX512 };
+
+      inline Isa detect() noexcept
+      {
+#ifdef ASCENT_SIMD_X86
+         __builtin_cpu_init();
+         if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+         if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::AVX2;
+         return Isa::SSE2;
+#else
+         return Isa::Scalar;
+#endif
+      }
+
+      // The instruction set used by the kernels, detected on first use
+      inline Isa& active_isa() noexcept
+      {
+         static Isa active = detect();
+         return active;
+      }
+
+      // Selects an instruction set, e.g. to benchmark the fallbacks. Requests beyond what the CPU supports are lowered to the detected set.
+      inline Isa select(const Isa requested) noexcept
+      {
+         return active_isa() = std::min(requested, detect());
+      }
+
+      // Smaller states skip the instruction set dispatch, it would cost more than it saves
+      inline constexpr size_t dispatch_size = 16;
+
+      // Fixed size states are left to the compiler, their loops have compile time bounds and are too short for a dispatch
+      template <class state_t>
+      concept contiguous_doubles = requires(state_t& s) {
+         { s.data() } -> std::convertible_to<const double*>;
+         { s.size() } -> std::convertible_to<size_t>;
+      } && std::same_as<typename state_t::value_type, double> && !fixed_size_state<state_t>;
+
+      namespace detail
+      {
+         // Instruction set traits. Intrinsic wrappers carry the target of their instruction set and are inlined once the kernel is inlined into a dispatch function of the same target.
+         struct scalar
+         {
+            static constexpr size_t width = 1; // kernels only run their element-wise remainder loop
+         };
+
+#ifdef ASCENT_SIMD_X86
+         struct sse2
+         {
+            using reg = __m128d;
+            static constexpr size_t width = 2;
+            static reg load(const double* p) noexcept { return _mm_loadu_pd(p); }
+            static void store(double* p, const reg v) noexcept { _mm_storeu_pd(p, v); }
+            static reg set1(const double v) noexcept { return _mm_set1_pd(v); }
+            static reg sub(const reg a, const reg b) noexcept { return _mm_sub_pd(a, b); }
+            static reg mul(const reg a, const reg b) noexcept { return _mm_mul_pd(a, b); }
+            static reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+            static reg abs(const reg a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+            static reg add(const reg a, const reg b) noexcept { return _mm_add_pd(a, b); }
+            static reg div(const reg a, const reg b) noexcept { return _mm_div_pd(a, b); }
+            static reg max(const reg a, const reg b) noexcept { return _mm_max_pd(a, b); }
+         };
+
+         struct avx2
+         {
+            using reg = __m256d;
+            static constexpr size_t width = 4;
+            [[gnu::target("avx2,fma")]] static reg load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+            [[gnu::target("avx2,fma")]] static void store(double* p, const reg v) noexcept { _mm256_storeu_pd(p, v); }
+            [[gnu::target("avx2,fma")]] static reg set1(const double v) noexcept { return _mm256_set1_pd(v); }
+            [[gnu::target("avx2,fma")]] static reg sub(const reg a, const reg b) noexcept { return _mm256_sub_pd(a, b); }
+            [[gnu::target("avx2,fma")]] static reg mul(const reg a, const reg b) noexcept { return _mm256_mul_pd(a, b); }
+            [[gnu::target("avx2,fma")]] static reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+            [[gnu::target("avx2,fma")]] static reg abs(const reg a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+            [[gnu::target("avx2,fma")]] static reg add(const reg a, const reg b) noexcept { return _mm256_add_pd(a, b); }
+            [[gnu::target("avx2,fma")]] static reg div(const reg a, const reg b) noexcept { return _mm256_div_pd(a, b); }
+            [[gnu::target("avx2,fma")]] static reg max(const reg a, const reg b) noexcept { return _mm256_max_pd(a, b); }
+         };
+
+         struct avx512
+         {
+            using reg = __m512d;
+            static constexpr size_t width = 8;
+            [[gnu::target("avx512f")]] static reg load(const double* p) noexcept { return _mm512_loadu_pd(p); }
+            [[gnu::target("avx512f")]] static void store(double* p, const reg v) noexcept { _mm512_storeu_pd(p, v); }
+            [[gnu::target("avx512f")]] static reg set1(const double v) noexcept { return _mm512_set1_pd(v); }
+            [[gnu::target("avx512f")]] static reg sub(const reg a, const reg b) noexcept { return _mm512_sub_pd(a, b); }
+            [[gnu::target("avx512f")]] static reg mul(const reg a, const reg b) noexcept { return _mm512_mul_pd(a, b); }
+            [[gnu::target("avx512f")]] static reg fmadd(const reg a, const reg b, const reg c) noexcept { return _mm512_fmadd_pd(a, b, c); }
+            [[gnu::target("avx512f")]] static reg abs(const reg a) noexcept { return _mm512_abs_pd(a); }
+            [[gnu::target("avx512f")]] static reg add(const reg a, const reg b) noexcept { return _mm512_add_pd(a, b); }
+            [[gnu::target("avx512f")]] static reg div(const reg a, const reg b) noexcept { return _mm512_div_pd(a, b); }
+            [[gnu::target("avx512f")]] static reg max(const reg a, const reg b) noexcept { return _mm512_maskz_max_pd(0xFF, a, b); } // the unmasked form trips -Wmaybe-uninitialized in GCC 12
+         };
+#endif
+
+         // c[0] * y[0][i] + ... + c[K-1] * y[K-1][i], the scalar remainder of the kernels
+         template <size_t K>
+         ASCENT_ALWAYS_INLINE double dot(const double* c, const double* const* y, const size_t i) noexcept
+         {
+            double s = c[0] * y[0][i];
+            for (size_t k = 1; k < K; ++k) {
+               s += c[k] * y[k][i];
+            }
+            return s;
+         }
+
+// Kernel bodies are always inlined into a dispatch function of their instruction set, so vectors never cross a function boundary without the matching target
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+         // out = x0 + h * (c[0] * y[0] + ... + c[K-1] * y[K-1])
+         template <size_t K>
+         struct Combine
+         {
+            template <class isa>
+            ASCENT_ALWAYS_INLINE static void run(double* __restrict out, const double* __restrict x0, const double h, const double* c, const double* const* y, const size_t n) noexcept
+            {
+               size_t i{};
+               if constexpr (isa::width > 1)
+               {
+                  const auto hv = isa::set1(h);
+                  for (; i + isa::width <= n; i += isa::width)
+                  {
+                     auto s = isa::mul(isa::set1(c[0]), isa::load(y[0] + i));
+                     for (size_t k = 1; k < K; ++k) {
+                        s = isa::fmadd(isa::set1(c[k]), isa::load(y[k] + i), s);
+                     }
+                     isa::store(out + i, isa::fmadd(hv, s, isa::load(x0 + i)));
+                  }
+               }
+               for (; i < n; ++i) {
+                  out[i] = x0[i] + h * dot<K>(c, y, i);
+               }
+            }
+         };
+
+         // out = |x0 + h * (c[0] * y[0] + ... + c[K-1] * y[K-1]) - x|, out may be one of y since each element is read before it is written
+         template <size_t K>
+         struct Residual
+         {
+            template <class isa>
+            ASCENT_ALWAYS_INLINE static void run(double* out, const double* __restrict x0, const double* __restrict x, const double h, const double* c, const double* const* y, const size_t n) noexcept
+            {
+               size_t i{};
+               if constexpr (isa::width > 1)
+               {
+                  const auto hv = isa::set1(h);
+                  for (; i + isa::width <= n; i += isa::width)
+                  {
+                     auto s = isa::mul(isa::set1(c[0]), isa::load(y[0] + i));
+                     for (size_t k = 1; k < K; ++k) {
+                        s = isa::fmadd(isa::set1(c[k]), isa::load(y[k] + i), s);
+                     }
+                     isa::store(out + i, isa::abs(isa::sub(isa::fmadd(hv, s, isa::load(x0 + i)), isa::load(x + i))));
+                  }
+               }
+               for (; i < n; ++i) {
+                  out[i] = std::abs(x0[i] + h * dot<K>(c, y, i) - x[i]);
+               }
+            }
+         };
+
+         // acc += a * y, out = x0 + h * y
+         struct Accumulate
+         {
+            template <class isa>
+            ASCENT_ALWAYS_INLINE static void run(double* __restrict acc, double* __restrict out, const double* __restrict x0, const double* __restrict y, const double a, const double h, const size_t n) noexcept
+            {
+               size_t i{};
+               if constexpr (isa::width > 1)
+               {
+                  const auto av = isa::set1(a);
+                  const auto hv = isa::set1(h);
+                  for (; i + isa::width <= n; i += isa::width)
+                  {
+                     const auto yi = isa::load(y + i);
+                     isa::store(acc + i, isa::fmadd(av, yi, isa::load(acc + i)));
+                     isa::store(out + i, isa::fmadd(hv, yi, isa::load(x0 + i)));
+                  }
+               }
+               for (; i < n; ++i)
+               {
+                  acc[i] += a * y[i];
+                  out[i] = h * y[i] + x0[i];
+               }
+            }
+         };
+
+         // dx = a * dx + h * y, x += b * dx and with an error register err += e * h * y. The first stage assigns dx and err instead.
+         template <bool first, bool error>
+         struct LowStorage
+         {
+            template <class isa>
+            ASCENT_ALWAYS_INLINE static void run(double* __restrict x, double* __restrict dx, const double* __restrict y, double* __restrict err, const double a, const double b, const double h, const double e, const size_t n) noexcept
+            {
+               size_t i{};
+               if constexpr (isa::width > 1)
+               {
+                  const auto av = isa::set1(a);
+                  const auto bv = isa::set1(b);
+                  const auto hv = isa::set1(h);
+                  const auto ev = isa::set1(e * h);
+                  for (; i + isa::width <= n; i += isa::width)
+                  {
+                     const auto yi = isa::load(y + i);
+                     const auto dxi = first ? isa::mul(hv, yi) : isa::fmadd(av, isa::load(dx + i), isa::mul(hv, yi));
+                     isa::store(dx + i, dxi);
+                     isa::store(x + i, isa::fmadd(bv, dxi, isa::load(x + i)));
+                     if constexpr (error) {
+                        isa::store(err + i, first ? isa::mul(ev, yi) : isa::fmadd(ev, yi, isa::load(err + i)));
+                     }
+                  }
+               }
+               for (; i < n; ++i)
+               {
+                  dx[i] = first ? h * y[i] : a * dx[i] + h * y[i];
+                  x[i] += b * dx[i];
+                  if constexpr (error) {
+                     err[i] = first ? e * h * y[i] : err[i] + e * h * y[i];
+                  }
+               }
+            }
+         };
+
+         // Scaled error q = err / (abs_tol + rel_tol * max(|x0|, |x|)) with scalar or per component tolerances,
+         // *result = max(*result, max q) or *result += sum q^2. err may be signed.
+         template <bool rms, bool per_component>
+         struct ErrorNorm
+         {
+            template <class isa>
+            ASCENT_ALWAYS_INLINE static void run(double* result, const double* __restrict err, const double* __restrict x0, const double* __restrict x, const double* abs_tol, const double* rel_tol, const double abs_s, const double rel_s, const size_t n) noexcept
+            {
+               auto scaled = [&](const size_t i) {
+                  const double a = per_component ? abs_tol[i] : abs_s;
+                  const double r = per_component ? rel_tol[i] : rel_s;
+                  return std::abs(err[i]) / (a + r * std::max(std::abs(x0[i]), std::abs(x[i])));
+               };
+
+               double acc = *result;
+               size_t i{};
+               if constexpr (isa::width > 1)
+               {
+                  auto accv = isa::set1(rms ? 0.0 : acc);
+                  const auto av = isa::set1(abs_s);
+                  const auto rv = isa::set1(rel_s);
+                  for (; i + isa::width <= n; i += isa::width)
+                  {
+                     const auto a = per_component ? isa::load(abs_tol + i) : av;
+                     const auto r = per_component ? isa::load(rel_tol + i) : rv;
+                     const auto sc = isa::fmadd(r, isa::max(isa::abs(isa::load(x0 + i)), isa::abs(isa::load(x + i))), a);
+                     const auto q = isa::div(isa::abs(isa::load(err + i)), sc);
+                     accv = rms ? isa::fmadd(q, q, accv) : isa::max(accv, q);
+                  }
+
+                  alignas(64) double lanes[isa::width];
+                  isa::store(lanes, accv);
+                  for (size_t k = 0; k < isa::width; ++k) {
+                     acc = rms ? acc + lanes[k] : std::max(acc, lanes[k]);
+                  }
+               }
+               for (; i < n; ++i)
+               {
+                  const double q = scaled(i);
+                  acc = rms ? acc + q * q : std::max(acc, q);
+               }
+               *result = acc;
+            }
+         };
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#ifdef ASCENT_SIMD_X86
+         template <class kernel_t, class... Args>
+         void run_sse2(Args... args) noexcept
+         {
+            kernel_t::template run<sse2>(args...);
+         }
+
+         template <class kernel_t, class... Args>
+         [[gnu::target("avx2,fma")]] void run_avx2(Args... args) noexcept
+         {
+            kernel_t::template run<avx2>(args...);
+         }
+
+         template <class kernel_t, class... Args>
+         [[gnu::target("avx512f")]] void run_avx512(Args... args) noexcept
+         {
+            kernel_t::template run<avx512>(args...);
+         }
+#endif
+
+         template <class kernel_t, class... Args>
+         void dispatch_isa(const size_t n, Args... args) noexcept
+         {
+            switch (active_isa())
+            {
+#ifdef ASCENT_SIMD_X86
+            case Isa::AVX512:
+               run_avx512<kernel_t>(args..., n);
+               return;
+            case Isa::AVX2:
+               run_avx2<kernel_t>(args..., n);
+               return;
+            case Isa::SSE2:
+               run_sse2<kernel_t>(args..., n);
+               return;
+#endif
+            default:
+               kernel_t::template run<scalar>(args..., n);
+            }
+         }
+
+         // Small states run the scalar kernel inline, so the compiler can still fold the coefficients
+         template <class kernel_t, class... Args>
+         ASCENT_ALWAYS_INLINE void dispatch(const size_t n, Args... args) noexcept
+         {
+            if (n < dispatch_size) {
+               kernel_t::template run<scalar>(args..., n);
+            }
+            else {
+               dispatch_isa<kernel_t>(n, args...);
+            }
+         }
+      }
+
+      // out = x0 + h * (c[0] * y[0] + ... + c[K-1] * y[K-1]), out must not alias the inputs
+      template <class state_t, size_t K>
+      void combine(state_t& out, const state_t& x0, const typename state_t::value_type h, const typename state_t::value_type (&c)[K], const state_t* const (&y)[K])
+      {
+         if constexpr (contiguous_doubles<state_t>)
+         {
+            const double* yp[K];
+            for (size_t k = 0; k < K; ++k) {
+               yp[k] = y[k]->data();
+            }
+            detail::dispatch<detail::Combine<K>>(out.size(), out.data(), x0.data(), h, &c[0], &yp[0]);
+         }
+         else
+         {
+            for_each_index(out, [&](const size_t i) {
+               auto s = c[0] * (*y[0])[i];
+               for (size_t k = 1; k < K; ++k) {
+                  s += c[k] * (*y[k])[i];
+               }
+               out[i] = x0[i] + h * s;
+            });
+         }
+      }
+
+      // out = |x0 + h * (c[0] * y[0] + ... + c[K-1] * y[K-1]) - x|, out may be one of y
+      template <class state_t, size_t K>
+      void residual(state_t& out, const state_t& x0, const state_t& x, const typename state_t::value_type h, const typename state_t::value_type (&c)[K], const state_t* const (&y)[K])
+      {
+         if constexpr (contiguous_doubles<state_t>)
+         {
+            const double* yp[K];
+            for (size_t k = 0; k < K; ++k) {
+               yp[k] = y[k]->data();
+            }
+            detail::dispatch<detail::Residual<K>>(x.size(), out.data(), x0.data(), x.data(), h, &c[0], &yp[0]);
+         }
+         else
+         {
+            for_each_index(x, [&](const size_t i) {
+               using std::abs;
+               auto s = c[0] * (*y[0])[i];
+               for (size_t k = 1; k < K; ++k) {
+                  s += c[k] * (*y[k])[i];
+               }
+               out[i] = abs(x0[i] + h * s - x[i]);
+            });
+         }
+      }
+
+      // acc += a * y, out = x0 + h * y, the arguments must not alias each other
+      template <class state_t>
+      void accumulate(state_t& acc, state_t& out, const state_t& x0, const state_t& y, const typename state_t::value_type a, const typename state_t::value_type h)
+      {
+         if constexpr (contiguous_doubles<state_t>)
+         {
+            detail::dispatch<detail::Accumulate>(out.size(), acc.data(), out.data(), x0.data(), y.data(), a, h);
+         }
+         else
+         {
+            for_each_index(out, [&](const size_t i) {
+               acc[i] += a * y[i];
+               out[i] = h * y[i] + x0[i];
+            });
+         }
+      }
+
+      // Williamson 2N stage: dx = a * dx + h * y, x += b * dx. The first stage assigns dx = h * y, so stale scratch is never read.
+      // With an error register, err += e * h * y (assigned on the first stage). The arguments must not alias each other.
+      template <bool first, class state_t>
+      void low_storage(state_t& x, state_t& dx, const state_t& y, const typename state_t::value_type a, const typename state_t::value_type b, const typename state_t::value_type h, state_t* err = nullptr, const typename state_t::value_type e = {})
+      {
+         if constexpr (contiguous_doubles<state_t>)
+         {
+            if (err) {
+               detail::dispatch<detail::LowStorage<first, true>>(x.size(), x.data(), dx.data(), y.data(), err->data(), a, b, h, e);
+            }
+            else {
+               detail::dispatch<detail::LowStorage<first, false>>(x.size(), x.data(), dx.data(), y.data(), static_cast<double*>(nullptr), a, b, h, e);
+            }
+         }
+         else
+         {
+            for_each_index(x, [&](const size_t i) {
+               dx[i] = first ? h * y[i] : a * dx[i] + h * y[i];
+               x[i] += b * dx[i];
+               if (err) {
+                  (*err)[i] = first ? e * h * y[i] : (*err)[i] + e * h * y[i];
+               }
+            });
+         }
+      }
+
+      // Norm of the error estimate err, scaled per component by abs_tol + rel_tol * max(|x0|, |x|) in a single pass.
+      // Excluded components have an infinite abs_tol and count as zero, the RMS norm still averages over every component.
+      template <class state_t, class value_t = typename state_t::value_type>
+      value_t error_norm(const state_t& err, const state_t& x0, const state_t& x, const AdaptiveT<value_t>& settings)
+      {
+         const size_t n = x.size();
+         const size_t n_abs = std::min(n, settings.abs_tols.size());
+         const size_t n_rel = std::min(n, settings.rel_tols.size());
+         const bool rms = settings.norm == Norm::RMS;
+
+         value_t acc{};
+         auto component = [&](const size_t i) {
+            using std::abs;
+            const value_t a = i < n_abs ? settings.abs_tols[i] : settings.abs_tol;
+            const value_t r = i < n_rel ? settings.rel_tols[i] : settings.rel_tol;
+            const value_t q = abs(err[i]) / (a + r * std::max(abs(x0[i]), abs(x[i])));
+            acc = rms ? acc + q * q : std::max(acc, q);
+         };
+         if constexpr (contiguous_doubles<state_t>)
+         {
+            auto run = [&]<bool per_component>(const size_t begin, const size_t end) {
+               if (rms) {
+                  detail::dispatch<detail::ErrorNorm<true, per_component>>(end - begin, &acc, err.data() + begin, x0.data() + begin, x.data() + begin, settings.abs_tols.data() + begin, settings.rel_tols.data() + begin, settings.abs_tol, settings.rel_tol);
+               }
+               else {
+                  detail::dispatch<detail::ErrorNorm<false, per_component>>(end - begin, &acc, err.data() + begin, x0.data() + begin, x.data() + begin, settings.abs_tols.data() + begin, settings.rel_tols.data() + begin, settings.abs_tol, settings.rel_tol);
+               }
+            };
+            // components with both tolerances of their own, then those with only one of them, then those with neither
+            const size_t both = std::min(n_abs, n_rel), either = std::max(n_abs, n_rel);
+            run.template operator()<true>(0, both);
+            for (size_t i = both; i < either; ++i) {
+               component(i);
+            }
+            run.template operator()<false>(either, n);
+         }
+         else {
+            for_each_index(x, component);
+         }
+
+         return rms ? std::sqrt(acc / static_cast<value_t>(n)) : acc;
+      }
+   }
+}
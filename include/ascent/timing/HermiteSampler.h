@@ -0,0 +1,156 @@
+// Copyright (c) 2016-2020 Anyar, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "ascent/Recorder.h"
+#include "ascent/modular/Link.h"
+#include "ascent/modular/Module.h"
+#include "ascent/timing/Sampler.h"
+
+#include <cmath>
+#include <vector>
+
+namespace asc
+{
+   // Records rows { t, x[0], x[1], ... } at a fixed sample rate by cubic Hermite interpolation between step boundaries,
+   // so the integrator keeps its base time step instead of shortening steps to land on sample times.
+   // A boundary is a state and the derivative the integrator already evaluated at the start of a step, so sampling costs no extra evaluations.
+   // The samples within a step are recorded once the boundary ending it is known, i.e. one step late.
+   template <class value_t>
+   struct HermiteSamplerT
+   {
+      HermiteSamplerT(RecorderT<value_t>& recorder, const value_t sample_rate) : sample_rate(sample_rate), recorder(recorder) {}
+
+      // Adds a step boundary and records the samples in (previous boundary, t], x and xd are indexable with a size()
+      template <class x_t, class xd_t>
+      void boundary(const value_t t, const x_t& x, const xd_t& xd)
+      {
+         const size_t n = x.size();
+         row.resize(n + 1);
+
+         if (x0.empty()) // the first boundary is recorded if it is a sample time
+         {
+            if (std::abs(std::round(t / sample_rate) * sample_rate - t) < eps)
+            {
+               row[0] = t;
+               for (size_t i = 0; i < n; ++i) {
+                  row[i + 1] = x[i];
+               }
+               recorder.push_back(row);
+            }
+         }
+         else
+         {
+            const value_t h = t - t0;
+            SamplerT<value_t>::samples(t0, t, sample_rate, [&](const value_t ts) {
+               const value_t s = (ts - t0) / h;
+               const value_t s2 = s * s;
+               const value_t s3 = s2 * s;
+               const value_t h00 = 2 * s3 - 3 * s2 + 1;
+               const value_t h10 = h * (s3 - 2 * s2 + s);
+               const value_t h01 = 3 * s2 - 2 * s3;
+               const value_t h11 = h * (s3 - s2);
+
+               row[0] = ts;
+               for (size_t i = 0; i < n; ++i) {
+                  row[i + 1] = h00 * x0[i] + h10 * xd0[i] + h01 * x[i] + h11 * xd[i];
+               }
+               recorder.push_back(row);
+            });
+         }
+
+         t0 = t;
+         x0.resize(n);
+         xd0.resize(n);
+         for (size_t i = 0; i < n; ++i)
+         {
+            x0[i] = x[i];
+            xd0[i] = xd[i];
+         }
+      }
+
+      // Wraps the system of a direct Runge Kutta integrator: the first evaluation of each integrator call is the start of a step and becomes a boundary.
+      // Usage: integrator(sampler.wrap(system), x, t, dt);
+      template <class System>
+      auto wrap(System& system)
+      {
+         return [this, &system, first = true](const auto& x, auto& xd, const value_t t) mutable {
+            system(x, xd, t);
+            if (first)
+            {
+               first = false;
+               boundary(t, x, xd);
+            }
+         };
+      }
+
+      value_t sample_rate{};
+
+   private:
+      static constexpr value_t eps = static_cast<value_t>(1.0e-8);
+
+      RecorderT<value_t>& recorder;
+      value_t t0{};
+      std::vector<value_t> x0, xd0, row;
+   };
+
+   namespace modular
+   {
+      // Feeds a HermiteSampler from the first update of every step, where the derivatives are evaluated at the step boundary.
+      // Add it to the blocks after the modules it samples so their derivatives are current when it updates. The sources are read through Links
+      // on every pass, so a Scheduler places it in a level after them and Link sequencing updates them first.
+      // t and pass refer to the simulation time and the pass of the integrator's propagator.
+      template <class value_t>
+      struct HermiteSampling : Module
+      {
+         HermiteSampling(HermiteSamplerT<value_t>& sampler, const value_t& t, const size_t& pass) : sampler(sampler), t(t), pass(pass) {}
+
+         std::vector<Module*> sources; // modules whose states are recorded, in order
+
+         void operator()() override
+         {
+            const bool boundary = pass == 0;
+            if (boundary)
+            {
+               x.clear();
+               xd.clear();
+            }
+            for (auto* source : sources)
+            {
+               Link<Module> link;
+               link = source;
+               auto& states = link->states;
+               if (boundary)
+               {
+                  for (auto& state : states)
+                  {
+                     x.emplace_back(*state.x);
+                     xd.emplace_back(*state.xd);
+                  }
+               }
+            }
+            if (boundary) {
+               sampler.boundary(t, x, xd);
+            }
+         }
+
+      private:
+         HermiteSamplerT<value_t>& sampler;
+         const value_t& t;
+         const size_t& pass;
+         std::vector<value_t> x, xd;
+      };
+   }
+}
@@ -1,300 +1,2219 @@
-// Copyright (c) 2016-2020 Anyar, Inc.
-// 
-// Licensed under the Apache License, Version 2.0 (the "License");
-// you may not use this file except in compliance with the License.
-// You may obtain a copy of the License at
-// 
-//      http://www.apache.org/licenses/LICENSE-2.0
-// 
-// Unless required by applicable law or agreed to in writing, software
-// distributed under the License is distributed on an "AS IS" BASIS,
-// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-// See the License for the specific language governing permissions and
-// limitations under the License.
-
-#include "ascent/Ascent.h"
-
-#include "ascent/integrators_modular/RK2.h"
-#include "ascent/integrators_modular/RK4.h"
-#include "ascent/integrators_modular/PC233.h"
-#include "ascent/integrators_modular/ABM4.h"
-#include "ascent/integrators_modular/VABM.h"
-#include "ascent/timing/Timing.h"
-
-#include <memory>
-
-using namespace asc;
-
-struct Airy
-{
-   void operator()(const state_t& x, state_t& xd, const double t)
-   {
-      xd[0] = x[1];
-      xd[1] = -t*x[0];
-   }
-};
-
-struct AiryMod : asc::Module
-{
-   double a{};
-   double a_d{};
-   double b{};
-   double b_d{};
-   std::shared_ptr<asc::Timing<double>> sim{};
-
-   void init()
-   {
-      make_state(a, a_d);
-      make_state(b, b_d);
-   }
-
-   void operator()()
-   {
-      a_d = b;
-      b_d = -sim->t*a; 
-   }
-};
-
-struct Exponential
-{
-   void operator()(const state_t& x, state_t& xd, const double)
-   {
-      xd[0] = x[0];
-   }
-}; 
-struct ExponentialMod : asc::Module
-{
-   double value{};
-   double deriv{};
-
-   void init()
-   {
-      make_state(value, deriv);
-   }
-   void operator()()
-   {
-      deriv = value;
-   }
-};
-
-template <class Integrator>
-state_t airy_test(const double dt)
-{
-   state_t x = { 1.0, 0.0 };
-   double t = 0.0;
-   double t_end = 10.0;
-
-   Integrator integrator;
-   Airy system;
-
-   while (t < t_end)
-   {
-      integrator(system, x, t, dt);
-   }
-
-   return x;
-}
-
-template <class Integrator>
-std::vector<double> airy_test_mod(const double dt)
-{
-   Integrator integrator;
-   auto system = std::make_shared<AiryMod>();
-   system->sim = std::make_shared<asc::Timing<double>>(); 
-   system->a = 1.0;
-   system->b = 0.0;
-   system->sim->t = 0.0;
-   system->sim->t_end = 10.0;
-   std::vector<asc::Module*> blocks{};
-   blocks.emplace_back(system.get());
-
-   system->init();
-
-   while (system->sim->t < system->sim->t_end)
-   {
-      integrator(blocks, system->sim->t, dt);
-   }
-
-   return{ system->a, system->b };
-}
-
-
-template <class Integrator>
-std::pair<state_t, double> exponential_test(const double dt)
-{
-   state_t x = { 1.0 };
-   double t = 0.0;
-   double t_end = 10.0;
-
-   Integrator integrator;
-   Exponential system;
-
-   while (t < t_end)
-   {
-      integrator(system, x, t, dt);
-   }
-
-   return{ x, t };
-}
-
-template <class Integrator>
-std::pair<double, double> exponential_test_mod(const double dt)
-{
-   Integrator integrator;
-   auto system = std::make_shared<ExponentialMod>();
-   auto sim = std::make_shared<asc::Timing<double>>();
-   system->value = 1.0;
-   sim->t = 0.0;
-   sim->t_end = 10.0;
-   std::vector<asc::Module*> blocks{};
-   blocks.emplace_back(system.get());
-
-   system->init();
-
-   while (sim->t < sim->t_end)
-   {
-      integrator(blocks, sim->t, dt);
-   }
-
-   return{ system->value, sim->t };
-}
-
-template <class Integrator>
-std::pair<double, double> exponential_test_mod_adaptive()
-{
-   Integrator integrator;
-   auto system = std::make_shared<ExponentialMod>();
-   auto sim = std::make_shared<asc::Timing<double>>();
-   auto settings = AdaptiveT<double>();
-   system->value = 1.0;
-   sim->t = 0.0;
-   sim->t_end = 10.0;
-   double dt = 0.001;
-   settings.abs_tol = 1e-16;
-   settings.rel_tol = 1e-16;
-   std::vector<asc::Module *> blocks{};
-   blocks.emplace_back(system.get());
-
-   system->init();
-
-   while (sim->t < sim->t_end)
-   {
-      integrator(blocks, sim->t, dt, settings);
-   }
-
-   return{ system->value, sim->t };
-}
-
-#include <boost/ut.hpp>
-
-using namespace boost::ut;
-
-inline bool approx(const auto& x, const auto near, const double epsilon = 1.0e-8) {
-   return (x <= (near + epsilon)) && (x >= (near - epsilon));
-}
-
-suite airy_system = []
-{
-   "airy_rk4"_test = [] {
-      auto x = airy_test<RK4>(0.001);
-      boost::ut::
-      expect(approx(x[0], -0.200693641142)) << x[0];
-      expect(approx(x[1], -1.49817601143)) << x[1];
-   };
-   
-   "airy_rk2"_test = [] {
-      auto x = airy_test<RK2>(0.001);
-      expect(approx(x[0], -0.200703911717)) << x[0];
-      expect(approx(x[1], -1.49816435475)) << x[1];
-   };
-   
-   "airy_dopri45"_test = [] {
-      auto x = airy_test<DOPRI45>(0.001);
-      expect(approx(x[0], -0.200693641142)) << x[0];
-      expect(approx(x[1], -1.49817601143)) << x[1];
-   };
-};
-
-suite airy_modular = []
-{
-   "airy_modular_rk4"_test = [] {
-      auto x = airy_test_mod<modular::RK4<double>>(0.001);
-      expect(approx(x[0], -0.200693641142)) << x[0];
-      expect(approx(x[1], -1.49817601143)) << x[1];
-   };
-   
-   "airy_modular_rk2"_test = [] {
-      auto x = airy_test_mod<modular::RK2<double>>(0.001);
-      expect(approx(x[0], -0.200703911717)) << x[0];
-      expect(approx(x[1], -1.49816435475)) << x[1];
-   };
-   
-   "airy_modular_pc233"_test = [] {
-      auto x = airy_test_mod<modular::PC233<double>>(0.001);
-      expect(approx(x[0], -0.200693641142)) << x[0];
-      expect(approx(x[1], -1.49817601143)) << x[1];
-   };
-};
-
-suite exponential = []
-{
-   "exp_rk4"_test = [] {
-      auto result = exponential_test<RK4>(0.001);
-      expect(approx(result.first[0], std::exp(result.second)));
-   };
-   
-   "exp_rk2"_test = [] {
-      auto result = exponential_test<RK2>(0.001);
-      expect(approx(result.first[0], std::exp(result.second), 1.0e-1));
-   };
-   
-   "exp_dopri45"_test = [] {
-      auto result = exponential_test<DOPRI45>(0.001);
-      expect(approx(result.first[0], std::exp(result.second)));
-   };
-   
-   "exp_pc233"_test = [] {
-      auto result = exponential_test<PC233>(0.001);
-      expect(approx(result.first[0], std::exp(result.second), 1.0e-2));
-   };
-   
-   "exp_abm4"_test = [] {
-      auto result = exponential_test<ABM4>(0.001);
-      expect(approx(result.first[0], std::exp(result.second)));
-   };
-};
-
-suite exp_modular = []
-{
-   "exp_modular_rk4"_test = [] {
-      auto result = exponential_test_mod<modular::RK4<double>>(0.001);
-      expect(approx(result.first, std::exp(result.second)));
-   };
-   
-   "exp_modular_rk2"_test = [] {
-      auto result = exponential_test_mod<modular::RK2<double>>(0.001);
-      expect(approx(result.first, std::exp(result.second), 1.0e-1));
-   };
-   
-   "exp_modular_pc233"_test = [] {
-      auto result = exponential_test_mod<modular::PC233<double>>(0.001);
-      expect(approx(result.first, std::exp(result.second), 1.0e-2));
-   };
-   
-   "exp_modular_abm4"_test = [] {
-      auto result = exponential_test_mod<modular::ABM4<double>>(0.001);
-      expect(approx(result.first, std::exp(result.second)));
-   };
-   
-   "exp_modular_vabm"_test = [] {
-      auto result = exponential_test_mod<modular::VABM<double>>(0.001);
-      expect(approx(result.first, std::exp(result.second)));
-   };
-   
-   "exp_modular_adaptive_vabm"_test = [] {
-      auto result = exponential_test_mod_adaptive<modular::VABM<double>>();
-      expect(approx(result.first, std::exp(result.second)));
-   };
-};
-
-int main() {}
+// Copyright (c) 2016-2020 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/Ascent.h"
+
+#include "ascent/integrators_modular/RK2.h"
+#include "ascent/integrators_modular/RK4.h"
+#include "ascent/integrators_modular/PC233.h"
+#include "ascent/integrators_modular/ABM4.h"
+#include "ascent/integrators_modular/VABM.h"
+#include "ascent/integrators_modular/DOPRI45.h"
+#include "ascent/integrators_modular/AutoSwitch.h"
+#include "ascent/integrators_modular/ExplicitRK.h"
+#include "ascent/integrators_modular/LowStorageRK.h"
+#include "ascent/integrators_modular/TRBDF2.h"
+#include "ascent/integrators_modular/NCRK4.h"
+#include "ascent/integrators_modular/Ralston4.h"
+#include "ascent/modular/MemoryUsage.h"
+#include "ascent/modular/ModuleGraph.h"
+#include "ascent/modular/Scheduler.h"
+#include "ascent/modular/StaticSystem.h"
+#include "ascent/timing/HermiteSampler.h"
+#include "ascent/timing/Timing.h"
+
+#include <array>
+#include <deque>
+#include <memory>
+
+using namespace asc;
+
+struct Airy
+{
+   void operator()(const state_t& x, state_t& xd, const double t)
+   {
+      xd[0] = x[1];
+      xd[1] = -t*x[0];
+   }
+};
+
+struct AiryMod : asc::Module
+{
+   double a{};
+   double a_d{};
+   double b{};
+   double b_d{};
+   std::shared_ptr<asc::Timing<double>> sim{};
+
+   void init()
+   {
+      make_state(a, a_d);
+      make_state(b, b_d);
+   }
+
+   void operator()()
+   {
+      a_d = b;
+      b_d = -sim->t*a; 
+   }
+};
+
+struct Exponential
+{
+   void operator()(const state_t& x, state_t& xd, const double)
+   {
+      xd[0] = x[0];
+   }
+}; 
+struct ExponentialMod : asc::Module
+{
+   double value{};
+   double deriv{};
+
+   void init()
+   {
+      make_state(value, deriv);
+   }
+   void operator()()
+   {
+      deriv = value;
+   }
+};
+
+// Makes its state in the constructor, so it must not be moved after construction
+struct ConstructedStateMod : asc::Module
+{
+   double value{};
+   double deriv{};
+
+   explicit ConstructedStateMod(const double value) : value(value)
+   {
+      make_state(this->value, deriv);
+   }
+   void operator()()
+   {
+      deriv = value;
+   }
+};
+
+// Propagates through the per-state propagator hook and then limits the state
+struct ClampedExponentialMod : ExponentialMod
+{
+   double limit = 2.0;
+
+   void propagate(asc::Propagator<double>& propagator, const double dt) override
+   {
+      for (auto& state : states) {
+         propagator(state, dt);
+      }
+      value = std::min(value, limit);
+   }
+};
+
+// Propagates through the default propagate and then limits the state
+struct ChainedClampMod : ExponentialMod
+{
+   double limit = 2.0;
+
+   void propagate(asc::Propagator<double>& propagator, const double dt) override
+   {
+      asc::Module::propagate(propagator, dt);
+      value = std::min(value, limit);
+   }
+};
+
+// Decays towards the output of its upstream module, the output is only valid once the upstream module has been updated
+struct ChainMod : asc::Module
+{
+   asc::Link<ChainMod> upstream;
+   double value = 1.0;
+   double deriv{};
+   double output{};
+   size_t n_update{};
+
+   void init()
+   {
+      make_state(value, deriv);
+   }
+   void operator()()
+   {
+      ++n_update;
+      output = value + (upstream ? 0.5 * upstream->output : 0.0);
+      deriv = -output;
+   }
+};
+
+// Fails every update
+struct ThrowingMod : asc::Module
+{
+   void operator()() { throw std::runtime_error("update failed"); }
+};
+
+// Node of a thermal network, conducting heat to its neighbours and, with a nonzero sink conductance, to a fixed temperature
+struct ThermalMod : asc::Module
+{
+   asc::Link<ThermalMod> left, right;
+   double conductance = 1.0e3; // to each neighbour
+   double sink{}; // conductance to the sink
+   double sink_temperature = 1.0;
+   double T{};
+   double Tdot{};
+
+   void init()
+   {
+      make_state(T, Tdot);
+   }
+   void operator()()
+   {
+      double q = sink * (sink_temperature - T);
+      if (left) q += conductance * (left->T - T);
+      if (right) q += conductance * (right->T - T);
+      Tdot = q;
+   }
+};
+
+// Relaxes towards cos(clock) at a rate that is only large while the clock is near 1.5, a system that is stiff during a transient
+struct ValveMod : asc::Module
+{
+   double x = 1.0;
+   double xd{};
+   double clock{};
+   double clock_d{};
+
+   void init()
+   {
+      make_state(x, xd);
+      make_state(clock, clock_d);
+   }
+   void operator()()
+   {
+      const double k = 1.0 + 1.0e5 * std::exp(-std::pow((clock - 1.5) / 0.25, 8));
+      xd = -k * (x - std::cos(clock)) - std::sin(clock);
+      clock_d = 1.0;
+   }
+};
+
+// Overrides hooks that chain to the defaults of their base
+struct ChainedDecayMod : asc::Module
+{
+   double x{};
+   double xd{};
+   size_t n_apply{};
+
+   void init()
+   {
+      states.clear();
+      make_state(x, xd);
+   }
+   void operator()() override
+   {
+      Module::operator()();
+      xd = -x;
+   }
+   void apply() override
+   {
+      Module::apply();
+      ++n_apply;
+   }
+};
+
+// Counts the calls of its phase hooks
+struct CountingMod : ExponentialMod
+{
+   size_t n_apply{};
+   size_t n_postcalc{};
+
+   void apply() override { ++n_apply; }
+   void postcalc() override { ++n_postcalc; }
+};
+
+template <class Integrator>
+state_t airy_test(const double dt)
+{
+   state_t x = { 1.0, 0.0 };
+   double t = 0.0;
+   double t_end = 10.0;
+
+   Integrator integrator;
+   Airy system;
+
+   while (t < t_end)
+   {
+      integrator(system, x, t, dt);
+   }
+
+   return x;
+}
+
+template <class Integrator>
+std::vector<double> airy_test_mod(const double dt)
+{
+   Integrator integrator;
+   auto system = std::make_shared<AiryMod>();
+   system->sim = std::make_shared<asc::Timing<double>>(); 
+   system->a = 1.0;
+   system->b = 0.0;
+   system->sim->t = 0.0;
+   system->sim->t_end = 10.0;
+   std::vector<asc::Module*> blocks{};
+   blocks.emplace_back(system.get());
+
+   system->init();
+
+   while (system->sim->t < system->sim->t_end)
+   {
+      integrator(blocks, system->sim->t, dt);
+   }
+
+   return{ system->a, system->b };
+}
+
+
+template <class Integrator>
+std::pair<state_t, double> exponential_test(const double dt)
+{
+   state_t x = { 1.0 };
+   double t = 0.0;
+   double t_end = 10.0;
+
+   Integrator integrator;
+   Exponential system;
+
+   while (t < t_end)
+   {
+      integrator(system, x, t, dt);
+   }
+
+   return{ x, t };
+}
+
+template <class Integrator>
+std::pair<double, double> exponential_test_mod(const double dt)
+{
+   Integrator integrator;
+   auto system = std::make_shared<ExponentialMod>();
+   auto sim = std::make_shared<asc::Timing<double>>();
+   system->value = 1.0;
+   sim->t = 0.0;
+   sim->t_end = 10.0;
+   std::vector<asc::Module*> blocks{};
+   blocks.emplace_back(system.get());
+
+   system->init();
+
+   while (sim->t < sim->t_end)
+   {
+      integrator(blocks, sim->t, dt);
+   }
+
+   return{ system->value, sim->t };
+}
+
+template <class Integrator>
+std::pair<double, double> exponential_test_mod_adaptive()
+{
+   Integrator integrator;
+   auto system = std::make_shared<ExponentialMod>();
+   auto sim = std::make_shared<asc::Timing<double>>();
+   auto settings = AdaptiveT<double>();
+   system->value = 1.0;
+   sim->t = 0.0;
+   sim->t_end = 10.0;
+   double dt = 0.001;
+   settings.abs_tol = 1e-16;
+   settings.rel_tol = 1e-16;
+   std::vector<asc::Module *> blocks{};
+   blocks.emplace_back(system.get());
+
+   system->init();
+
+   while (sim->t < sim->t_end)
+   {
+      integrator(blocks, sim->t, dt, settings);
+   }
+
+   return{ system->value, sim->t };
+}
+
+#include <boost/ut.hpp>
+
+using namespace boost::ut;
+
+inline bool approx(const auto& x, const auto near, const double epsilon = 1.0e-8) {
+   return (x <= (near + epsilon)) && (x >= (near - epsilon));
+}
+
+suite airy_system = []
+{
+   "airy_rk4"_test = [] {
+      auto x = airy_test<RK4>(0.001);
+      boost::ut::
+      expect(approx(x[0], -0.200693641142)) << x[0];
+      expect(approx(x[1], -1.49817601143)) << x[1];
+   };
+   
+   "airy_rk2"_test = [] {
+      auto x = airy_test<RK2>(0.001);
+      expect(approx(x[0], -0.200703911717)) << x[0];
+      expect(approx(x[1], -1.49816435475)) << x[1];
+   };
+   
+   "airy_dopri45"_test = [] {
+      auto x = airy_test<DOPRI45>(0.001);
+      expect(approx(x[0], -0.200693641142)) << x[0];
+      expect(approx(x[1], -1.49817601143)) << x[1];
+   };
+};
+
+suite airy_modular = []
+{
+   "airy_modular_rk4"_test = [] {
+      auto x = airy_test_mod<modular::RK4<double>>(0.001);
+      expect(approx(x[0], -0.200693641142)) << x[0];
+      expect(approx(x[1], -1.49817601143)) << x[1];
+   };
+   
+   "airy_modular_rk2"_test = [] {
+      auto x = airy_test_mod<modular::RK2<double>>(0.001);
+      expect(approx(x[0], -0.200703911717)) << x[0];
+      expect(approx(x[1], -1.49816435475)) << x[1];
+   };
+   
+   "airy_modular_pc233"_test = [] {
+      auto x = airy_test_mod<modular::PC233<double>>(0.001);
+      expect(approx(x[0], -0.200693641142)) << x[0];
+      expect(approx(x[1], -1.49817601143)) << x[1];
+   };
+};
+
+suite exponential = []
+{
+   "exp_rk4"_test = [] {
+      auto result = exponential_test<RK4>(0.001);
+      expect(approx(result.first[0], std::exp(result.second)));
+   };
+   
+   "exp_rk2"_test = [] {
+      auto result = exponential_test<RK2>(0.001);
+      expect(approx(result.first[0], std::exp(result.second), 1.0e-1));
+   };
+   
+   "exp_dopri45"_test = [] {
+      auto result = exponential_test<DOPRI45>(0.001);
+      expect(approx(result.first[0], std::exp(result.second)));
+   };
+   
+   "exp_pc233"_test = [] {
+      auto result = exponential_test<PC233>(0.001);
+      expect(approx(result.first[0], std::exp(result.second), 1.0e-2));
+   };
+   
+   "exp_abm4"_test = [] {
+      auto result = exponential_test<ABM4>(0.001);
+      expect(approx(result.first[0], std::exp(result.second)));
+   };
+};
+
+suite simd_kernels = []
+{
+   "simd_isa_agree"_test = [] {
+      const size_t n = 13; // exercises the remainder loop of every width
+      state_t x0(n), y0(n), y1(n);
+      for (size_t i = 0; i < n; ++i)
+      {
+         x0[i] = 1.0 + i;
+         y0[i] = 0.5 * i - 3.0;
+         y1[i] = std::sin(double(i));
+      }
+
+      for (auto isa : { simd::Isa::Scalar, simd::Isa::SSE2, simd::Isa::AVX2, simd::Isa::AVX512 })
+      {
+         simd::select(isa);
+
+         state_t out(n), stage(n), acc = y1;
+         simd::combine(out, x0, 0.1, { 2.0, -1.0 }, { &y0, &y1 });
+         simd::accumulate(acc, stage, x0, y0, 2.0, 0.5);
+         expect(approx(acc[n - 1], y1[n - 1] + 2.0 * y0[n - 1], 1.0e-14));
+         expect(approx(stage[n - 1], x0[n - 1] + 0.5 * y0[n - 1], 1.0e-14));
+
+         state_t err = y0;
+         simd::residual(err, x0, out, 0.1, { 2.0, -1.0 }, { &err, &y1 }); // the error may overwrite an input
+         for (size_t i = 0; i < n; ++i)
+         {
+            expect(approx(out[i], x0[i] + 0.1 * (2.0 * y0[i] - y1[i]), 1.0e-14)) << int(isa) << i;
+            expect(err[i] < 1.0e-14) << int(isa) << i;
+         }
+      }
+      simd::select(simd::detect());
+   };
+
+   "simd_deque_fallback"_test = [] {
+      auto system = [](const auto& x, auto& xd, const double) { xd[0] = x[0]; };
+      std::deque<double> x{ 1.0 };
+      double t{};
+      RK4T<std::deque<double>> integrator;
+      while (t < 1.0) {
+         integrator(system, x, t, 0.001);
+      }
+      expect(approx(x[0], std::exp(t)));
+   };
+};
+
+suite ensemble = []
+{
+   "ensemble_members"_test = [] {
+      const size_t n = 11;
+      std::vector<double> k(n);
+      Ensemble<RK4> sweep(2, n);
+      for (size_t m = 0; m < n; ++m)
+      {
+         k[m] = 0.1 * m;
+         sweep.member(m, { 1.0, 0.0 });
+      }
+
+      // damped oscillators with per member damping, one call per stage for every member
+      auto batch = [&](auto x, auto xd, const double) {
+         for (size_t m = 0; m < x.size(); ++m)
+         {
+            xd[0][m] = x[1][m];
+            xd[1][m] = -x[0][m] - k[m] * x[1][m];
+         }
+      };
+
+      double t{};
+      while (t < 1.0) {
+         sweep(batch, t, 0.01);
+      }
+
+      for (size_t m = 0; m < n; ++m)
+      {
+         state_t x = { 1.0, 0.0 };
+         double tm{};
+         RK4 integrator;
+         auto system = [&](const state_t& x, state_t& xd, const double) {
+            xd[0] = x[1];
+            xd[1] = -x[0] - k[m] * x[1];
+         };
+         while (tm < 1.0) {
+            integrator(system, x, tm, 0.01);
+         }
+         expect(approx(sweep(0, m), x[0], 1.0e-12) && approx(sweep.member(m)[1], x[1], 1.0e-12)) << m;
+      }
+   };
+
+   "ensemble_adaptive"_test = [] {
+      const size_t n = 6;
+      const std::vector<double> k{ 0.1, 0.5, 1.0, 5.0, 20.0, 50.0 };
+      std::vector<size_t> evaluations(n);
+      EnsembleDOPRI45 sweep(1, n, 0.1);
+      for (size_t m = 0; m < n; ++m) {
+         sweep(0, m) = 1.0;
+      }
+
+      auto batch = [&](auto x, auto xd, const double*) {
+         for (size_t l = 0; l < x.size(); ++l)
+         {
+            const size_t m = x.member(l);
+            xd[0][l] = -k[m] * x[0][l];
+            ++evaluations[m];
+         }
+      };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-10;
+      settings.rel_tol = 1.0e-10;
+      size_t steps{};
+      while (sweep(batch, 1.0, settings)) {
+         ++steps;
+      }
+
+      for (size_t m = 0; m < n; ++m)
+      {
+         expect(approx(sweep.t[m], 1.0, 1.0e-12)) << m;
+         expect(approx(sweep(0, m), std::exp(-k[m]), 1.0e-8)) << m << " " << sweep(0, m);
+      }
+      expect(evaluations[0] < evaluations[n - 1] / 4) << "slow members take their own, larger steps";
+      expect(evaluations[n - 1] <= 6 * (steps + sweep.n_rejections) + 1) << "only pending members are evaluated";
+   };
+};
+
+suite fixed_size = []
+{
+   using array_t = std::array<double, 2>;
+   static_assert(std::is_trivially_copyable_v<RK4T<array_t>> && std::is_trivially_copyable_v<DOPRI45T<array_t>> && std::is_trivially_copyable_v<ABM4T<array_t>>);
+
+   auto compare = []<template <class> class integrator_t>() {
+      auto airy = [](const auto& x, auto& xd, const double t) {
+         xd[0] = x[1];
+         xd[1] = -t * x[0];
+      };
+
+      array_t x{ 1.0, 0.0 };
+      state_t y{ 1.0, 0.0 };
+      double tx{}, ty{};
+      integrator_t<array_t> fixed;
+      integrator_t<state_t> dynamic;
+      for (size_t i = 0; i < 1000; ++i)
+      {
+         fixed(airy, x, tx, 0.01);
+         dynamic(airy, y, ty, 0.01);
+      }
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+
+   "fixed_euler"_test = [&] { compare.operator()<EulerT>(); };
+   "fixed_midpoint"_test = [&] { compare.operator()<MidpointT>(); };
+   "fixed_rk2"_test = [&] { compare.operator()<RK2T>(); };
+   "fixed_rk4"_test = [&] { compare.operator()<RK4T>(); };
+   "fixed_dopri45"_test = [&] { compare.operator()<DOPRI45T>(); };
+   "fixed_pc233"_test = [&] { compare.operator()<PC233T>(); };
+   "fixed_abm4"_test = [&] { compare.operator()<ABM4T>(); };
+   "fixed_rtam4"_test = [&] { compare.operator()<RTAM4T>(); };
+};
+
+suite explicit_rk = []
+{
+   static_assert(tableau::nonzero<tableau::RK4, 2>().size() == 1 && tableau::nonzero<tableau::RK3, 3>().size() == 2, "zero weights are pruned");
+   static_assert(std::is_trivially_copyable_v<ExplicitRKT<tableau::RK4, std::array<double, 2>>>);
+
+   "explicit_rk4"_test = [] {
+      auto x = airy_test<ExplicitRK<tableau::RK4>>(0.001);
+      auto y = airy_test<RK4>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+
+   "explicit_midpoint"_test = [] {
+      auto x = airy_test<ExplicitRK<tableau::Midpoint>>(0.001);
+      auto y = airy_test<RK2>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+
+   "explicit_modular_rk4"_test = [] {
+      auto x = airy_test_mod<modular::ExplicitRK<tableau::RK4, double>>(0.001);
+      auto y = airy_test_mod<modular::RK4<double>>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+
+   "explicit_modular_ralston4"_test = [] {
+      auto x = airy_test_mod<modular::ExplicitRK<tableau::Ralston4, double>>(0.001);
+      auto y = airy_test_mod<modular::Ralston4<double>>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+
+   "explicit_modular_rk38"_test = [] {
+      auto x = airy_test_mod<modular::ExplicitRK<tableau::RK38, double>>(0.001);
+      auto y = airy_test_mod<modular::NCRK4<double>>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+   };
+};
+
+suite low_storage = []
+{
+   "low_storage_ck45"_test = [] {
+      auto x = airy_test<LowStorageRK<tableau::CK45>>(0.001);
+      expect(approx(x[0], -0.200693641142)) << x[0];
+      expect(approx(x[1], -1.49817601143)) << x[1];
+   };
+
+   "low_storage_adaptive"_test = [] {
+      auto airy = [](const state_t& x, state_t& xd, const double t) {
+         xd[0] = x[1];
+         xd[1] = -t * x[0];
+      };
+
+      state_t x{ 1.0, 0.0 };
+      double t{}, dt = 0.01;
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-10;
+      settings.rel_tol = 1.0e-10;
+      LowStorageRK<tableau::CK45> integrator;
+      while (t < 10.0)
+      {
+         dt = std::min(dt, 10.0 - t);
+         integrator(airy, x, t, dt, settings);
+      }
+
+      state_t y{ 1.0, 0.0 };
+      double ty{};
+      RK4 reference;
+      for (size_t i = 0; i < 10000; ++i) {
+         reference(airy, y, ty, 0.001);
+      }
+      expect(approx(x[0], y[0], 1.0e-8) && approx(x[1], y[1], 1.0e-8));
+   };
+
+   "low_storage_modular"_test = [] {
+      auto x = airy_test_mod<modular::LowStorageRK<tableau::CK45, double>>(0.001);
+      auto y = airy_test<LowStorageRK<tableau::CK45>>(0.001);
+      expect(approx(x[0], y[0], 1.0e-12) && approx(x[1], y[1], 1.0e-12));
+
+      modular::LowStorageRK<tableau::Williamson3, double> integrator;
+      ExponentialMod module;
+      std::vector<asc::Module*> blocks{ &module };
+      module.init();
+      double t{};
+      integrator(blocks, t, 0.01);
+      expect(integrator.propagator.arena.columns() == 1) << "a fixed step keeps one arena column per state";
+   };
+};
+
+suite dense_output = []
+{
+   "dense_sampling"_test = [] {
+      auto system = [](const state_t& x, state_t& xd, const double t) {
+         xd[0] = std::cos(t);
+         xd[1] = -x[1];
+      };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-8;
+      settings.rel_tol = 1.0e-8;
+
+      // sampling by shortening steps
+      size_t truncated_steps{};
+      {
+         state_t x{ 0.0, 1.0 };
+         double t{}, dt = 0.01;
+         DOPRI45 integrator;
+         while (t < 10.0)
+         {
+            Sampler sampler(t, dt);
+            sampler(0.01);
+            integrator(system, x, t, dt, settings);
+            sampler.base_time_step(dt);
+            ++truncated_steps;
+         }
+      }
+
+      // sampling the dense output
+      size_t dense_steps{}, n_samples{};
+      double error{};
+      state_t x{ 0.0, 1.0 }, xs;
+      double t{}, dt = 0.01;
+      DOPRI45 integrator;
+      integrator.dense_output = true;
+      while (t < 10.0)
+      {
+         integrator(system, x, t, dt, settings);
+         ++dense_steps;
+         Sampler::samples(integrator.step_start(), t, 0.01, [&](const double ts) {
+            integrator.interpolate(xs, x, ts);
+            error = std::max({ error, std::abs(xs[0] - std::sin(ts)), std::abs(xs[1] - std::exp(-ts)) });
+            ++n_samples;
+         });
+      }
+
+      expect(n_samples >= 1000);
+      expect(error < 1.0e-6) << error;
+      expect(10 * dense_steps < truncated_steps) << dense_steps << truncated_steps;
+   };
+
+   "dense_modular"_test = [] {
+      ExponentialMod module;
+      module.value = 1.0;
+      module.init();
+      std::vector<asc::Module*> blocks{ &module };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-8;
+      settings.rel_tol = 1.0e-8;
+
+      modular::DOPRI45<double> integrator;
+      integrator.dense_output = true;
+      double t{}, dt = 0.01, error{};
+      while (t < 2.0)
+      {
+         integrator(blocks, t, dt, settings);
+         const double end = module.value;
+         Sampler::samples(integrator.step_start(), t, 0.05, [&](const double ts) {
+            integrator.interpolate(ts, [&](const double) {
+               error = std::max(error, std::abs(module.value - std::exp(ts)) / std::exp(ts));
+            });
+         });
+         expect(module.value == end) << "states are restored";
+      }
+      expect(error < 1.0e-6) << error;
+   };
+};
+
+suite hermite_sampling = []
+{
+   "hermite_direct"_test = [] {
+      size_t evaluations{};
+      auto system = [&](const state_t&, state_t& xd, const double t) {
+         xd[0] = std::cos(t);
+         ++evaluations;
+      };
+
+      Recorder recorder;
+      HermiteSamplerT<double> sampler(recorder, 0.033);
+      state_t x{ 0.0 };
+      double t{};
+      RK4 integrator;
+      size_t steps{};
+      while (t < 10.0 - 1.0e-8)
+      {
+         integrator(sampler.wrap(system), x, t, 0.1);
+         ++steps;
+      }
+
+      expect(steps == 100 && evaluations == 4 * steps) << "the base step is kept";
+      expect(recorder.history.size() > 300);
+      double error{};
+      for (auto& row : recorder.history) {
+         error = std::max(error, std::abs(row[1] - std::sin(row[0])));
+      }
+      expect(error < 1.0e-5) << error;
+   };
+
+   "hermite_modular"_test = [] {
+      Timing<double> timing;
+      ExponentialMod module;
+      module.value = 1.0;
+      module.init();
+
+      modular::RK4<double> integrator;
+      Recorder recorder;
+      HermiteSamplerT<double> sampler(recorder, 0.05);
+      modular::HermiteSampling<double> sampling(sampler, timing.t, integrator.propagator.pass);
+      sampling.sources.emplace_back(&module);
+      std::vector<asc::Module*> blocks{ &module, &sampling };
+
+      while (timing.t < 2.0 - 1.0e-8) {
+         integrator(blocks, timing.t, 0.1);
+      }
+
+      expect(recorder.history.size() == 39) << "samples up to the last boundary, t = 1.9";
+      double error{};
+      for (auto& row : recorder.history) {
+         error = std::max(error, std::abs(row[1] - std::exp(row[0])) / std::exp(row[0]));
+      }
+      expect(error < 1.0e-4) << error;
+
+      // a Scheduler updates the sampling after its sources, also when it is added first
+      ExponentialMod source;
+      source.value = 1.0;
+      source.init();
+      modular::RK4<double> parallel;
+      double t{};
+      Recorder scheduled_recorder;
+      HermiteSamplerT<double> scheduled_sampler(scheduled_recorder, 0.05);
+      modular::HermiteSampling<double> scheduled(scheduled_sampler, t, parallel.propagator.pass);
+      scheduled.sources.emplace_back(&source);
+      Pool pool(2);
+      Scheduler scheduler(pool);
+      scheduler.emplace_back(&scheduled);
+      scheduler.emplace_back(&source);
+      for (size_t i = 0; i < 3; ++i) {
+         parallel(scheduler, t, 0.1);
+      }
+      expect(scheduled_recorder.history.size() == size_t{ 5 }) << "samples up to the last boundary, t = 0.2";
+      for (auto& row : scheduled_recorder.history) {
+         expect(approx(row[1], std::exp(row[0]), 1.0e-4)) << row[0] << row[1];
+      }
+      expect(scheduler.n_levels() == size_t{ 2 });
+      expect(scheduler.level(1).size() == size_t{ 1 } && scheduler.level(1)[0].module == &scheduled);
+   };
+};
+
+suite step_control = []
+{
+   "pi_controller"_test = [] {
+      // the step size is limited by stability rather than accuracy, where the elementary controller oscillates
+      auto rejections = [](const StepController& controller) {
+         size_t evaluations{}, steps{};
+         auto system = [&](const state_t& x, state_t& xd, const double t) {
+            xd[0] = -500.0 * (x[0] - std::cos(t));
+            ++evaluations;
+         };
+
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-3;
+         settings.rel_tol = 1.0e-3;
+
+         state_t x{ 0.0 };
+         double t{}, dt = 0.001;
+         DOPRI45 integrator;
+         integrator.controller = controller;
+         while (t < 10.0)
+         {
+            integrator(system, x, t, dt, settings);
+            ++steps;
+         }
+         return (evaluations - 1) / 6 - steps; // six evaluations per attempt after the first
+      };
+
+      const size_t rejections_i = rejections(StepController::I());
+      const size_t rejections_pi = rejections(StepController::PI());
+      expect(rejections_i > 100) << rejections_i;
+      expect(rejections_pi < 10) << rejections_pi;
+      expect(rejections(StepController::PID()) < 10);
+   };
+
+   "initial_step"_test = [] {
+      auto system = [](const state_t& x, state_t& xd, const double) {
+         xd[0] = x[1];
+         xd[1] = -x[0];
+      };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-8;
+      settings.rel_tol = 1.0e-8;
+
+      state_t x{ 1.0, 0.0 }, xd(2), x1, xd1;
+      system(x, xd, 0.0);
+      const double h0 = initial_step(system, x, xd, x1, xd1, 0.0, 5, settings);
+      expect(h0 > 1.0e-3 && h0 < 0.1) << h0;
+
+      // dt = 0 lets the integrators estimate their first step
+      double t{}, dt{};
+      DOPRI45 integrator;
+      integrator(system, x, t, dt, settings);
+      expect(t > 0.0 && dt > 0.0);
+      while (t < 5.0) {
+         integrator(system, x, t, dt, settings);
+      }
+      expect(approx(x[0], std::cos(t), 1.0e-6));
+
+      ExponentialMod module;
+      module.value = 1.0;
+      module.init();
+      std::vector<asc::Module*> blocks{ &module };
+
+      modular::DOPRI45<double> modular_integrator;
+      t = 0.0;
+      dt = 0.0;
+      while (t < 1.0) {
+         modular_integrator(blocks, t, dt, settings);
+      }
+      expect(approx(module.value, std::exp(t), 1.0e-6));
+   };
+
+   "rkmm"_test = [] {
+      auto system = [](const state_t& x, state_t& xd, const double) {
+         xd[0] = -x[0];
+      };
+
+      state_t x{ 1.0 };
+      double t{}, dt = 0.1;
+      RKMM integrator(1.0e-8);
+      while (t < 5.0) {
+         integrator(system, x, t, dt);
+      }
+      expect(approx(x[0], std::exp(-t), 1.0e-7));
+   };
+};
+
+suite tolerances = []
+{
+   "per_component"_test = [] {
+      // a slow component that needs a tight tolerance and a fast one that does not
+      auto run = [](const AdaptiveT<double>& settings, double& error) {
+         auto system = [](const state_t& x, state_t& xd, const double t) {
+            xd[0] = -x[0];
+            xd[1] = 1.0e3 * std::cos(10.0 * t);
+         };
+
+         state_t x{ 1.0, 0.0 };
+         double t{}, dt = 0.01;
+         size_t steps{};
+         DOPRI45 integrator;
+         while (t < 5.0)
+         {
+            integrator(system, x, t, dt, settings);
+            ++steps;
+         }
+         error = std::abs(x[0] - std::exp(-t));
+         return steps;
+      };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-8;
+      settings.rel_tol = 1.0e-8;
+      double error{};
+      const size_t uniform = run(settings, error);
+
+      settings.tolerance(1, 1.0, 1.0e-2);
+      const size_t per_component = run(settings, error);
+      expect(2 * per_component < uniform) << per_component << uniform;
+      expect(error < 1.0e-7) << error;
+
+      settings.exclude(1);
+      expect(run(settings, error) <= per_component);
+      expect(error < 1.0e-7) << error;
+
+      settings.norm = Norm::RMS;
+      expect(run(settings, error) <= per_component);
+   };
+
+   "mismatched_tolerances"_test = [] {
+      // abs_tols and rel_tols of different sizes each cover their own components
+      auto reference = [](const auto& err, const auto& x, const AdaptiveT<double>& settings) {
+         double acc{};
+         for (size_t i = 0; i < x.size(); ++i)
+         {
+            const double a = i < settings.abs_tols.size() ? settings.abs_tols[i] : settings.abs_tol;
+            const double r = i < settings.rel_tols.size() ? settings.rel_tols[i] : settings.rel_tol;
+            acc = std::max(acc, std::abs(err[i]) / (a + r * std::abs(x[i])));
+         }
+         return acc;
+      };
+
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-6;
+      settings.rel_tol = 1.0e-6;
+      settings.abs_tols.assign(20, 1.0e-3);
+      settings.rel_tols.assign(5, 1.0e-2);
+      state_t err(40, 1.0e-6), x(40, 1.0);
+      for (size_t i = 0; i < x.size(); ++i) {
+         err[i] *= 1.0 + 0.1 * static_cast<double>(i % 7);
+      }
+      expect(approx(simd::error_norm(err, x, x, settings), reference(err, x, settings), 1.0e-14));
+
+      std::deque<double> err_d(err.begin(), err.end()), x_d(x.begin(), x.end());
+      expect(approx(simd::error_norm(err_d, x_d, x_d, settings), reference(err, x, settings), 1.0e-14));
+
+      std::swap(settings.abs_tols, settings.rel_tols);
+      expect(approx(simd::error_norm(err, x, x, settings), reference(err, x, settings), 1.0e-14));
+
+      AdaptiveT<double> sparse;
+      sparse.abs_tols.resize(5);
+      sparse.tolerance(3, 1.0, 1.0);
+      expect(sparse.abs_tols.size() == size_t{ 5 } && sparse.rel_tols.size() == size_t{ 4 });
+   };
+
+   "initial_step_tolerances"_test = [] {
+      // a fast component excluded from error control must not shrink the first step
+      auto system = [](const state_t& x, state_t& xd, const double) {
+         xd[0] = 1.0e6;
+         xd[1] = -x[1];
+      };
+      AdaptiveT<double> settings;
+      settings.abs_tol = 1.0e-6;
+      settings.rel_tol = 1.0e-6;
+      state_t x0{ 0.0, 1.0 }, xd0(2), x1, xd1;
+      system(x0, xd0, 0.0);
+      const double uniform = initial_step(system, x0, xd0, x1, xd1, 0.0, 5, settings);
+      settings.exclude(0);
+      const double excluded = initial_step(system, x0, xd0, x1, xd1, 0.0, 5, settings);
+      expect(excluded > 1000.0 * uniform) << excluded << uniform;
+
+      // the same through Module::tolerances
+      auto run = [](const bool exclude) {
+         ExponentialMod slow, fast;
+         slow.value = 1.0;
+         fast.value = 1.0e6;
+         slow.init();
+         fast.init();
+         if (exclude) fast.exclude(0);
+         std::vector<asc::Module*> blocks{ &slow, &fast };
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-6;
+         settings.rel_tol = 0.0;
+         double t{};
+         const double dt = modular::initial_step(blocks, t, 5, settings);
+         expect(t == 0.0 && fast.value == 1.0e6);
+         return dt;
+      };
+      expect(run(true) > 5.0 * run(false)) << run(true) << run(false);
+   };
+
+   "modular_tolerances"_test = [] {
+      auto run = [](const bool loose, const Norm norm) {
+         ExponentialMod a, b;
+         a.value = 1.0;
+         b.value = 1.0;
+         a.init();
+         b.init();
+         if (loose)
+         {
+            a.tolerance(1.0e-3, 1.0e-3);
+            b.exclude(0);
+         }
+         std::vector<asc::Module*> blocks{ &a, &b };
+
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-10;
+         settings.rel_tol = 1.0e-10;
+         settings.norm = norm;
+
+         modular::DOPRI45<double> integrator;
+         double t{}, dt = 0.01;
+         size_t steps{};
+         while (t < 2.0)
+         {
+            integrator(blocks, t, dt, settings);
+            ++steps;
+         }
+         expect(approx(a.value, std::exp(t), loose ? 1.0e-2 : 1.0e-8));
+         return steps;
+      };
+
+      const size_t tight = run(false, Norm::Max);
+      const size_t loose = run(true, Norm::Max);
+      expect(4 * loose < tight) << loose << tight;
+      expect(run(false, Norm::RMS) <= tight);
+   };
+};
+
+// Robertson's chemical kinetics, a classic stiff problem
+struct Robertson
+{
+   void operator()(const state_t& x, state_t& xd, const double)
+   {
+      ++evaluations;
+      xd[0] = -0.04 * x[0] + 1.0e4 * x[1] * x[2];
+      xd[2] = 3.0e7 * x[1] * x[1];
+      xd[1] = -xd[0] - xd[2];
+   }
+
+   size_t evaluations{};
+};
+
+// Robertson with an analytic Jacobian
+struct RobertsonJacobian : Robertson
+{
+   void jacobian(const state_t& x, MatrixT<double>& J, const double)
+   {
+      J(0, 0) = -0.04;
+      J(0, 1) = 1.0e4 * x[2];
+      J(0, 2) = 1.0e4 * x[1];
+      J(2, 0) = 0.0;
+      J(2, 1) = 6.0e7 * x[1];
+      J(2, 2) = 0.0;
+      for (size_t j = 0; j < 3; ++j) {
+         J(1, j) = -J(0, j) - J(2, j);
+      }
+   }
+};
+
+template <class Integrator, class System = Robertson>
+size_t robertson_test(Integrator& integrator, System& system, state_t& x)
+{
+   AdaptiveT<double> settings;
+   settings.abs_tol = 1.0e-10;
+   settings.rel_tol = 1.0e-6;
+
+   x = { 1.0, 0.0, 0.0 };
+   double t{}, dt{};
+   size_t steps{};
+   while (t < 40.0)
+   {
+      if (t + dt > 40.0) {
+         dt = 40.0 - t;
+      }
+      integrator(system, x, t, dt, settings);
+      ++steps;
+   }
+   return steps;
+}
+
+suite implicit = []
+{
+   auto check = [](const state_t& x) {
+      expect(approx(x[0], 0.7158271, 1.0e-5)) << x[0];
+      expect(approx(x[1], 9.185535e-6, 1.0e-9)) << x[1];
+      expect(approx(x[2], 0.2841637, 1.0e-5)) << x[2];
+   };
+
+   "robertson_rosenbrock"_test = [&] {
+      Rosenbrock<tableau::ROS34PW2> integrator;
+      Robertson system;
+      state_t x;
+      const size_t steps = robertson_test(integrator, system, x);
+      check(x);
+      expect(steps < 1000) << steps;
+      expect(integrator.matrix.n_jacobians < steps / 10) << integrator.matrix.n_jacobians;
+      expect(integrator.matrix.n_factorizations < steps) << integrator.matrix.n_factorizations;
+   };
+
+   "robertson_sdirk"_test = [&] {
+      SDIRK<tableau::SDIRK4> integrator;
+      Robertson system;
+      state_t x;
+      const size_t steps = robertson_test(integrator, system, x);
+      check(x);
+      expect(steps < 500) << steps;
+      expect(integrator.matrix.n_factorizations < steps) << integrator.matrix.n_factorizations;
+   };
+
+   "robertson_bdf"_test = [&] {
+      BDF integrator;
+      Robertson system;
+      state_t x;
+      const size_t steps = robertson_test(integrator, system, x);
+      check(x);
+      expect(steps < 500) << steps;
+      expect(integrator.matrix.n_factorizations < steps / 2) << integrator.matrix.n_factorizations;
+      expect(system.evaluations < 4 * steps) << system.evaluations;
+   };
+
+   "bdf_order_selection"_test = [] {
+      // the order with the largest step factor wins, as in ode15s
+      expect(BDF::order_change(2.0, 1.0, 3.0) == 1) << "raising the order allows the larger step";
+      expect(BDF::order_change(3.0, 1.0, 2.0) == -1);
+      expect(BDF::order_change(1.0, 2.0, 1.5) == 0);
+      expect(BDF::order_change(2.0, 2.0, 1.0) == -1) << "ties keep the lower order";
+      expect(BDF::order_change(0.0, 1.0, 1.0) == 0);
+      expect(BDF::order_change(0.0, 0.0, 0.0) == 0);
+   };
+
+   "analytic_jacobian"_test = [&] {
+      BDF integrator;
+      RobertsonJacobian system;
+      state_t x;
+      robertson_test(integrator, system, x);
+      check(x);
+      expect(integrator.matrix.jacobian.evaluations == size_t{});
+   };
+
+   "explicit_comparison"_test = [] {
+      // x' = -1000 (x - cos t) - sin t has the smooth solution cos t, but limits explicit steps to stability
+      auto run = [](auto integrator) {
+         auto system = [](const state_t& x, state_t& xd, const double t) { xd[0] = -1000.0 * (x[0] - std::cos(t)) - std::sin(t); };
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-6;
+         settings.rel_tol = 1.0e-6;
+         state_t x{ 1.0 };
+         double t{}, dt{};
+         size_t steps{};
+         while (t < 10.0)
+         {
+            if (t + dt > 10.0) {
+               dt = 10.0 - t;
+            }
+            integrator(system, x, t, dt, settings);
+            ++steps;
+         }
+         expect(approx(x[0], std::cos(t), 1.0e-5)) << x[0];
+         return steps;
+      };
+
+      const size_t dopri = run(DOPRI45{});
+      expect(10 * run(Rosenbrock<tableau::ROS34PW2>{}) < dopri);
+      expect(10 * run(BDF{}) < dopri);
+   };
+   "sparse_jacobian"_test = [] {
+      // a chain of stiff springs, each mass only couples to its neighbours
+      auto run = [](const size_t sparse_min, size_t& colors) {
+         constexpr size_t n_masses = 30;
+         auto chain = [](const state_t& x, state_t& xd, const double) {
+            for (size_t i = 0; i < n_masses; ++i)
+            {
+               const double s_left = i > 0 ? x[2 * i - 2] : 0.0;
+               const double v_left = i > 0 ? x[2 * i - 1] : 0.0;
+               double f = -1.0e4 * (x[2 * i] - s_left) - 50.0 * (x[2 * i + 1] - v_left);
+               if (i + 1 < n_masses) {
+                  f += 1.0e4 * (x[2 * i + 2] - x[2 * i]) + 50.0 * (x[2 * i + 3] - x[2 * i + 1]);
+               }
+               xd[2 * i] = x[2 * i + 1];
+               xd[2 * i + 1] = f + (i + 1 == n_masses ? 1.0 : 0.0);
+            }
+         };
+
+         Rosenbrock<tableau::ROS34PW2> integrator;
+         integrator.matrix.sparse_min = sparse_min;
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-8;
+         settings.rel_tol = 1.0e-6;
+         state_t x(2 * n_masses);
+         double t{}, dt{};
+         while (t < 1.0)
+         {
+            if (t + dt > 1.0) {
+               dt = 1.0 - t;
+            }
+            integrator(chain, x, t, dt, settings);
+         }
+         colors = integrator.matrix.sparse ? integrator.matrix.jacobian.n_colors : 0;
+         return std::make_pair(x.back(), integrator.matrix.jacobian.evaluations / integrator.matrix.n_jacobians);
+      };
+
+      size_t colors{};
+      const auto dense = run(1000, colors);
+      expect(colors == size_t{});
+      const auto sparse = run(32, colors);
+      expect(colors == size_t{ 6 }) << colors; // a mass couples to the positions and velocities of its neighbours
+      expect(approx(sparse.first, dense.first, 1.0e-8)) << sparse.first << dense.first;
+      expect(5 * sparse.second < dense.second) << sparse.second << dense.second;
+   };
+
+   "parallel_jacobian"_test = [] {
+      constexpr size_t n = 40;
+      auto ring = [](const state_t& x, state_t& xd, const double) {
+         for (size_t i = 0; i < n; ++i) {
+            xd[i] = -x[i] * x[i] + 2.0 * x[(i + 1) % n] - std::sin(x[(i + n - 1) % n]);
+         }
+      };
+      auto safe_ring = thread_safe(ring);
+      static_assert(!is_thread_safe_v<decltype(ring)>);
+      static_assert(is_thread_safe_v<decltype(safe_ring)>);
+
+      state_t x(n), xd(n);
+      for (size_t i = 0; i < n; ++i) {
+         x[i] = 0.1 * static_cast<double>(i);
+      }
+      ring(x, xd, 0.0);
+
+      Pool pool(4);
+      JacobianT<state_t> serial, parallel;
+      parallel.pool = &pool;
+
+      MatrixT<double> J_serial, J_parallel;
+      serial(ring, x, xd, 0.0, J_serial);
+      parallel(safe_ring, x, xd, 0.0, J_parallel);
+      expect(serial.evaluations == n && parallel.evaluations == n);
+      bool same = true;
+      for (size_t i = 0; i < n; ++i) {
+         for (size_t j = 0; j < n; ++j) same = same && J_serial(i, j) == J_parallel(i, j);
+      }
+      expect(same);
+
+      serial.detect(ring, x, 0.0);
+      parallel.detect(safe_ring, x, 0.0);
+      expect(parallel.pattern.cols == serial.pattern.cols && parallel.pattern.nnz() == 3 * n);
+      expect(parallel.n_colors == serial.n_colors && parallel.n_colors <= size_t{ 4 }) << parallel.n_colors;
+
+      SparseMatrixT<double> S_serial, S_parallel;
+      S_serial.assign(serial.pattern);
+      S_parallel.assign(parallel.pattern);
+      serial(ring, x, xd, 0.0, S_serial);
+      parallel(safe_ring, x, xd, 0.0, S_parallel);
+      expect(S_parallel.values == S_serial.values);
+      expect(parallel.evaluations == serial.evaluations);
+      for (size_t i = 0; i < n; ++i) {
+         expect(approx(S_parallel.values[parallel.pattern.find(i, i)], J_serial(i, i), 1.0e-6));
+      }
+   };
+
+   "sparse_pivot_fallback"_test = [] {
+      // 2x2 blocks J = [[2, 1], [1, 0]]: I - 0.5 J has a zero diagonal pivot but is regular, it needs pivoting
+      constexpr size_t n = 32;
+      auto blocks = [](const state_t& x, state_t& xd, const double) {
+         for (size_t i = 0; i < n; i += 2)
+         {
+            xd[i] = 2.0 * x[i] + x[i + 1];
+            xd[i + 1] = x[i];
+         }
+      };
+
+      state_t x(n, 1.0), xd(n);
+      blocks(x, xd, 0.0);
+      IterationMatrixT<state_t> matrix;
+      matrix.refresh(blocks, x, xd, 0.0);
+      expect(matrix.sparse);
+
+      expect(matrix.factor(0.5));
+      expect(matrix.n_dense_fallbacks == size_t{ 1 });
+      state_t b(n), y(n);
+      for (size_t i = 0; i < n; ++i) {
+         y[i] = b[i] = 1.0 + 0.1 * static_cast<double>(i);
+      }
+      matrix.solve(y);
+      bool solved = true;
+      for (size_t i = 0; i < n; i += 2)
+      {
+         // (I - 0.5 J) y = b
+         solved &= std::abs(-0.5 * y[i + 1] - b[i]) < 1.0e-12;
+         solved &= std::abs(-0.5 * y[i] + y[i + 1] - b[i + 1]) < 1.0e-12;
+      }
+      expect(solved);
+
+      expect(matrix.factor(0.1)) << "regular pivots use the sparse LU again";
+      expect(matrix.n_dense_fallbacks == size_t{ 1 });
+   };
+
+   "sparse_lu"_test = [] {
+      // tridiagonal with a coupling of the ends
+      constexpr size_t n = 8;
+      std::vector<std::vector<size_t>> rows(n);
+      MatrixT<double> A(n);
+      for (size_t i = 0; i < n; ++i)
+      {
+         A(i, i) = 4.0 + static_cast<double>(i);
+         if (i > 0) A(i, i - 1) = -1.0;
+         if (i + 1 < n) A(i, i + 1) = -2.0;
+      }
+      A(0, n - 1) = 0.5;
+      A(n - 1, 0) = 0.25;
+
+      for (size_t i = 0; i < n; ++i) {
+         for (size_t j = 0; j < n; ++j) {
+            if (A(i, j) != 0.0) rows[i].emplace_back(j);
+         }
+      }
+      SparsityPattern pattern;
+      pattern.assign(rows);
+      std::vector<size_t> colors;
+      expect(color_columns(pattern, colors) >= size_t{ 3 });
+      for (size_t i = 0; i < n; ++i) {
+         for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) {
+            for (size_t l = k + 1; l < pattern.row_ptr[i + 1]; ++l) expect(colors[pattern.cols[k]] != colors[pattern.cols[l]]);
+         }
+      }
+
+      SparseMatrixT<double> S;
+      S.assign(pattern);
+      for (size_t i = 0; i < n; ++i) {
+         for (size_t k = pattern.row_ptr[i]; k < pattern.row_ptr[i + 1]; ++k) S.values[k] = A(i, pattern.cols[k]);
+      }
+      SparseLUT<double> sparse;
+      sparse.analyze(pattern);
+      LUT<double> dense;
+      expect(sparse.factor(S));
+      expect(dense.factor(A));
+
+      state_t b(n), c(n);
+      for (size_t i = 0; i < n; ++i) {
+         b[i] = c[i] = std::sin(static_cast<double>(i));
+      }
+      sparse.solve(b);
+      dense.solve(c);
+      for (size_t i = 0; i < n; ++i) {
+         expect(approx(b[i], c[i], 1.0e-12)) << i;
+      }
+   };
+
+   "modular_trbdf2"_test = [] {
+      // a stiff thermal chain, conduction limits explicit steps long after the transient
+      auto run = [](auto integrator, const double tol, std::vector<double>& T) {
+         std::vector<ThermalMod> nodes(20);
+         std::vector<asc::Module*> blocks;
+         for (size_t i = 0; i < nodes.size(); ++i)
+         {
+            if (i > 0) nodes[i].left = &nodes[i - 1];
+            if (i + 1 < nodes.size()) nodes[i].right = &nodes[i + 1];
+            blocks.emplace_back(&nodes[i]);
+         }
+         nodes.front().sink = 1.0e4;
+         for (auto& node : nodes) {
+            node.init();
+         }
+
+         AdaptiveT<double> settings;
+         settings.abs_tol = tol;
+         settings.rel_tol = tol;
+         double t{}, dt{};
+         size_t steps{};
+         while (t < 2.0)
+         {
+            if (t + dt > 2.0) {
+               dt = 2.0 - t;
+            }
+            integrator(blocks, t, dt, settings);
+            ++steps;
+         }
+         T.clear();
+         for (auto& node : nodes) {
+            T.emplace_back(node.T);
+         }
+         return steps;
+      };
+
+      std::vector<double> reference, T;
+      const size_t dopri = run(modular::DOPRI45<double>{}, 1.0e-8, reference);
+      modular::TRBDF2<double> integrator;
+      const size_t trbdf2 = run(std::ref(integrator), 1.0e-5, T);
+      expect(20 * trbdf2 < dopri) << trbdf2 << dopri;
+      for (size_t i = 0; i < T.size(); ++i) {
+         expect(approx(T[i], reference[i], 1.0e-4)) << i << T[i] << reference[i];
+      }
+
+      // the preconditioner's Jacobian takes three update passes over the tridiagonal Link connectivity, and saves Krylov iterations
+      expect(integrator.n_colors == size_t{ 3 }) << integrator.n_colors;
+      modular::TRBDF2<double> unpreconditioned;
+      unpreconditioned.precondition = false;
+      run(std::ref(unpreconditioned), 1.0e-5, T);
+      expect(2 * integrator.krylov_iterations < unpreconditioned.krylov_iterations) << integrator.krylov_iterations << unpreconditioned.krylov_iterations;
+      expect(integrator.evaluations < unpreconditioned.evaluations);
+
+      // fixed steps are second order
+      auto fixed = [](const double dt) {
+         ExponentialMod a;
+         a.value = 1.0;
+         a.init();
+         std::vector<asc::Module*> blocks{ &a };
+         modular::TRBDF2<double> integrator;
+         double t{};
+         for (size_t i = 0; i < static_cast<size_t>(1.0 / dt + 0.5); ++i) {
+            integrator(blocks, t, dt);
+         }
+         return std::abs(a.value - std::exp(t));
+      };
+      const double ratio = fixed(0.02) / fixed(0.01);
+      expect(ratio > 3.5 && ratio < 4.5) << ratio;
+   };
+
+   "auto_switch"_test = [] {
+      // stiff while t is near 1.5, the solution is cos(t) throughout
+      auto valve = [](const state_t& x, state_t& xd, const double t) {
+         const double k = 1.0 + 1.0e5 * std::exp(-std::pow((t - 1.5) / 0.25, 8));
+         xd[0] = -k * (x[0] - std::cos(t)) - std::sin(t);
+      };
+      auto run = [&](auto& integrator) {
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-8;
+         settings.rel_tol = 1.0e-8;
+         state_t x{ 1.0 };
+         double t{}, dt{};
+         size_t steps{};
+         while (t < 3.0)
+         {
+            if (t + dt > 3.0) {
+               dt = 3.0 - t;
+            }
+            integrator(valve, x, t, dt, settings);
+            ++steps;
+         }
+         expect(approx(x[0], std::cos(3.0), 1.0e-6)) << x[0];
+         return steps;
+      };
+
+      DOPRI45 dopri;
+      const size_t explicit_steps = run(dopri);
+      AutoSwitch<> integrator;
+      expect(10 * run(integrator) < explicit_steps);
+      expect(!integrator.switching.stiff());
+
+      const auto& switches = integrator.switching.switches;
+      expect(switches.size() == size_t{ 2 }) << switches.size();
+      if (switches.size() == 2)
+      {
+         expect(switches[0].stiff && switches[0].t > 1.0 && switches[0].t < 1.5) << switches[0].t;
+         expect(!switches[1].stiff && switches[1].t > 1.5) << switches[1].t;
+      }
+
+      AutoSwitch<Rosenbrock<tableau::ROS34PW2>> rosenbrock;
+      expect(2 * run(rosenbrock) < explicit_steps);
+      expect(!rosenbrock.switching.switches.empty());
+   };
+
+   "modular_auto_switch"_test = [] {
+      auto run = [](auto& integrator) {
+         ValveMod valve;
+         valve.init();
+         std::vector<asc::Module*> blocks{ &valve };
+
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-8;
+         settings.rel_tol = 1.0e-8;
+         double t{}, dt{};
+         size_t steps{};
+         while (t < 3.0)
+         {
+            if (t + dt > 3.0) {
+               dt = 3.0 - t;
+            }
+            integrator(blocks, t, dt, settings);
+            ++steps;
+         }
+         expect(approx(valve.x, std::cos(3.0), 1.0e-6)) << valve.x;
+         return steps;
+      };
+
+      modular::DOPRI45<double> dopri;
+      const size_t explicit_steps = run(dopri);
+      modular::AutoSwitch<double> integrator;
+      expect(10 * run(integrator) < explicit_steps);
+
+      const auto& switches = integrator.switching.switches;
+      expect(switches.size() == size_t{ 2 }) << switches.size();
+      if (switches.size() == 2) {
+         expect(switches[0].stiff && !switches[1].stiff && switches[0].t < 1.5 && switches[1].t > 1.5);
+      }
+   };
+};
+
+suite exp_modular = []
+{
+   "exp_modular_rk4"_test = [] {
+      auto result = exponential_test_mod<modular::RK4<double>>(0.001);
+      expect(approx(result.first, std::exp(result.second)));
+   };
+   
+   "exp_modular_rk2"_test = [] {
+      auto result = exponential_test_mod<modular::RK2<double>>(0.001);
+      expect(approx(result.first, std::exp(result.second), 1.0e-1));
+   };
+   
+   "exp_modular_pc233"_test = [] {
+      auto result = exponential_test_mod<modular::PC233<double>>(0.001);
+      expect(approx(result.first, std::exp(result.second), 1.0e-2));
+   };
+   
+   "exp_modular_abm4"_test = [] {
+      auto result = exponential_test_mod<modular::ABM4<double>>(0.001);
+      expect(approx(result.first, std::exp(result.second)));
+   };
+   
+   "exp_modular_vabm"_test = [] {
+      auto result = exponential_test_mod<modular::VABM<double>>(0.001);
+      expect(approx(result.first, std::exp(result.second)));
+   };
+   
+   "exp_modular_adaptive_vabm"_test = [] {
+      auto result = exponential_test_mod_adaptive<modular::VABM<double>>();
+      expect(approx(result.first, std::exp(result.second)));
+   };
+};
+
+suite state_arena = []
+{
+   "arena_sync"_test = [] {
+      ExponentialMod a, b;
+      a.init();
+      b.init();
+      std::vector<asc::Module*> blocks{ &a, &b };
+
+      StateArena<double> arena(2);
+      expect(arena.sync(blocks));
+      expect(!arena.sync(blocks));
+      expect(arena.size() == 2);
+      expect(a.states[0].index == 0 && b.states[0].index == 1);
+      expect(arena.x[1] == &b.value && arena.xd[1] == &b.deriv);
+
+      arena(1, b.states[0].index) = 3.0;
+
+      ExponentialMod c;
+      c.init();
+      blocks.insert(blocks.begin(), &c);
+      expect(arena.sync(blocks));
+      expect(b.states[0].index == 2);
+      expect(arena(1, 2) == 3.0) << "stage memory follows its state";
+      expect(arena(1, 0) == 0.0);
+   };
+
+   "arena_replaced_module"_test = [] {
+      // a module replaced by another with as many states must not keep the rows of the one it replaces
+      ExponentialMod a, b, c;
+      a.value = 1.0;
+      b.value = 1.0;
+      c.value = 2.0;
+      a.init();
+      b.init();
+      c.init();
+      std::vector<asc::Module*> blocks{ &a, &b };
+
+      modular::RK4<double> integrator;
+      double t{};
+      integrator(blocks, t, 0.1);
+      const double stepped = b.value;
+
+      blocks[1] = &c;
+      integrator(blocks, t, 0.1);
+      expect(b.value == stepped) << "the replaced module is left alone";
+      expect(approx(c.value, 2.0 * std::exp(0.1), 1.0e-6)) << c.value;
+      expect(approx(a.value, std::exp(0.2), 1.0e-6)) << a.value;
+
+      StateArena<double> arena(1);
+      expect(arena.sync(blocks));
+      std::vector<asc::Module*> other{ &a, &b };
+      expect(arena.sync(other)) << "another set of blocks of the same size";
+      expect(b.states[0].index == 1 && arena.x[1] == &b.value);
+   };
+
+   "arena_history"_test = [] {
+      ExponentialMod a, b;
+      a.init();
+      b.init();
+      std::vector<asc::Module*> blocks{ &a, &b };
+
+      StateArena<double> arena(1);
+      arena.sync(blocks);
+      arena.history(2);
+      for (double v : { 1.0, 2.0, 3.0 })
+      {
+         a.value = v;
+         b.deriv = -v;
+         arena.record();
+      }
+      expect(arena.history_size() == 2);
+      expect(arena.x_history(0)[0] == 2.0 && arena.x_history(1)[0] == 3.0) << "oldest entry first, the first record is overwritten";
+      expect(arena.xd_history(1)[1] == -3.0);
+
+      ExponentialMod c;
+      c.init();
+      blocks.insert(blocks.begin(), &c);
+      arena.sync(blocks);
+      expect(arena.x_history(1)[a.states[0].index] == 3.0) << "history follows its state";
+   };
+
+   "arenas_share_states"_test = [] {
+      auto run = [](const bool interleave) {
+         ExponentialMod a, b;
+         a.value = 1.0;
+         b.value = 2.0;
+         a.init();
+         b.init();
+         std::vector<asc::Module*> blocks{ &a, &b };
+         std::vector<asc::Module*> reversed{ &b, &a };
+
+         modular::ABM4<double> integrator;
+         modular::RK4<double> other;
+         double t{}, t_other{};
+         for (size_t i = 0; i < 20; ++i)
+         {
+            integrator(blocks, t, 0.01);
+            if (interleave) {
+               other(reversed, t_other, 0.0); // renumbers the states without changing them
+            }
+         }
+         return std::array<double, 2>{ a.value, b.value };
+      };
+
+      const auto reference = run(false);
+      const auto interleaved = run(true);
+      expect(interleaved[0] == reference[0] && interleaved[1] == reference[1]) << "the derivative history follows its state across arenas";
+      expect(approx(reference[0], std::exp(0.2)));
+   };
+
+   "memory_usage"_test = [] {
+      ModuleGraph graph;
+      for (size_t i = 0; i < 10; ++i) {
+         graph.emplace_back<ExponentialMod>();
+      }
+      for (auto* m : graph) {
+         m->init();
+      }
+
+      modular::ABM4<double> integrator;
+      double t{};
+      integrator(graph, t, 0.01);
+
+      const auto usage = memory_usage(graph, integrator);
+      expect(usage.modules == 10 && usage.states == 10);
+      expect(usage.module_bytes >= 10 * sizeof(ExponentialMod));
+      expect(usage.state_bytes >= 10 * sizeof(State));
+      expect(usage.arena_bytes >= 10 * (6 + 8) * sizeof(double)) << "stage columns and start up history";
+      expect(integrator.initializer.propagator.arena.bytes() > 0);
+      expect(usage.arena_bytes == integrator.propagator.arena.bytes() + integrator.initializer.propagator.arena.bytes()) << "the start up integrator is counted";
+      expect(usage.total_bytes() == usage.module_bytes + usage.state_bytes + usage.arena_bytes);
+
+      modular::AutoSwitch<double> switching;
+      AdaptiveT<double> settings;
+      double dt = 0.01;
+      switching(graph, t, dt, settings);
+      const size_t bytes = switching.dopri.propagator.arena.bytes() + switching.implicit.propagator.arena.bytes();
+      expect(bytes > 0);
+      expect(memory_usage(graph, switching).arena_bytes == bytes) << "integrators without a propagator of their own";
+   };
+};
+
+suite batch_propagation = []
+{
+   "mixed_custom_propagate"_test = [] {
+      ExponentialMod a, c;
+      ClampedExponentialMod b;
+      a.value = b.value = c.value = 1.0;
+      a.init();
+      b.init();
+      c.init();
+      std::vector<asc::Module*> blocks{ &a, &b, &c };
+
+      modular::RK4<double> integrator;
+      double t{};
+      while (t < 1.0 - 1.0e-8) {
+         integrator(blocks, t, 0.001);
+      }
+
+      // held as Module*, the default propagate is detected from the vtable where its layout is known
+      if (detail::final_overrider(a, &asc::Module::propagate))
+      {
+         expect(keeps_default<&asc::Module::propagate>(a) && keeps_default<&asc::Module::propagate>(c));
+         expect(!keeps_default<&asc::Module::propagate>(b));
+         ChainedClampMod chained;
+         expect(!keeps_default<&asc::Module::propagate>(chained));
+      }
+      expect(approx(a.value, std::exp(t))) << a.value;
+      expect(approx(c.value, std::exp(t))) << c.value;
+      expect(b.value == b.limit) << b.value;
+   };
+
+   "pointer_blocks_batch"_test = [] {
+      // Euler steps that count the states propagated one at a time
+      struct CountingProp : BatchPropagator<CountingProp, double>
+      {
+         CountingProp() : BatchPropagator<CountingProp, double>(1) {}
+         size_t n_single{};
+
+         void operator()(State& state, const double dt) override
+         {
+            ++n_single;
+            BatchPropagator<CountingProp, double>::operator()(state, dt);
+         }
+
+         void batch(const StateSpan<double>& s, const size_t, const double dt)
+         {
+            for (size_t i = 0; i < s.size(); ++i) {
+               *s.x[i] += dt * *s.xd[i];
+            }
+         }
+      };
+
+      ExponentialMod a, c;
+      ClampedExponentialMod b;
+      a.value = b.value = c.value = 1.0;
+      a.deriv = b.deriv = c.deriv = 1.0;
+      a.init();
+      b.init();
+      c.init();
+      std::vector<asc::Module*> blocks{ &a, &b, &c };
+
+      CountingProp propagator;
+      asc::propagate(blocks, propagator, 0.5);
+      expect(a.value == 1.5 && b.value == 1.5 && c.value == 1.5);
+      if (detail::final_overrider(a, &asc::Module::propagate)) {
+         expect(propagator.n_single == size_t{ 1 }) << "only the custom module propagates state by state";
+      }
+   };
+
+   "chained_propagate"_test = [] {
+      // an override that calls Module::propagate() must keep running
+      auto run = [](auto& blocks, ChainedClampMod& m) {
+         m.value = 1.0;
+         m.init();
+         modular::RK4<double> integrator;
+         double t{};
+         for (size_t i = 0; i < 100; ++i) {
+            integrator(blocks, t, 0.01);
+         }
+         expect(m.value == m.limit) << m.value;
+         expect(!m.batch_propagate);
+      };
+
+      ChainedClampMod a;
+      std::vector<asc::Module*> modules{ &a };
+      run(modules, a);
+
+      ChainedClampMod b;
+      std::vector<ChainedClampMod*> typed{ &b };
+      run(typed, b);
+
+      ChainedClampMod c;
+      Scheduler scheduler;
+      scheduler.emplace_back(&c);
+      run(scheduler, c);
+
+      ExponentialMod d;
+      Scheduler defaults;
+      defaults.emplace_back(&d);
+      expect(d.batch_propagate);
+   };
+};
+
+suite module_graph = []
+{
+   "graph_buckets"_test = [] {
+      ModuleGraph graph;
+      auto first = graph.emplace_back<ExponentialMod>();
+      ExponentialMod* address = &graph[first];
+
+      std::vector<Handle<ClampedExponentialMod>> clamped;
+      for (size_t i = 0; i < 600; ++i)
+      {
+         if (i % 200 == 0) clamped.emplace_back(graph.emplace_back<ClampedExponentialMod>());
+         graph.emplace_back<ExponentialMod>();
+      }
+      expect(&graph[first] == address) << "handles and addresses are stable";
+      expect(graph.n_buckets() == 2 && graph.size() == 604);
+
+      for (auto* module : graph) {
+         static_cast<ExponentialMod*>(module)->value = 1.0;
+      }
+      init(graph);
+
+      modular::RK4<double> integrator;
+      double t{};
+      while (t < 1.0 - 1.0e-8) {
+         integrator(graph, t, 0.001);
+      }
+
+      expect(approx(graph[first].value, std::exp(t))) << graph[first].value;
+      expect(graph[Handle<ExponentialMod>{ first.bucket, 600 }].value == graph[first].value);
+      for (auto& handle : clamped) {
+         expect(graph[handle].value == graph[handle].limit);
+      }
+   };
+
+   "graph_constructs_in_place"_test = [] {
+      ModuleGraph graph;
+      auto handle = graph.emplace_back<ConstructedStateMod>(1.0);
+      auto& module = graph[handle];
+      expect(module.states[0].x == &module.value) << "states made in the constructor point into the stored module";
+
+      modular::RK4<double> integrator;
+      double t{};
+      for (size_t i = 0; i < 100; ++i) {
+         integrator(graph, t, 0.01);
+      }
+      expect(approx(module.value, std::exp(t))) << module.value;
+   };
+};
+
+suite static_system = []
+{
+   auto compare = []<class Integrator>() {
+      StaticSystem<ChainMod, ChainMod, ClampedExponentialMod, CountingMod> system;
+      system.get<1>().upstream = &system.get<0>();
+      system.get<2>().value = system.get<3>().value = 1.0;
+      init(system);
+
+      ChainMod a, b;
+      ClampedExponentialMod c;
+      CountingMod d;
+      b.upstream = &a;
+      c.value = d.value = 1.0;
+      std::vector<asc::Module*> blocks{ &a, &b, &c, &d };
+      init(blocks);
+
+      Integrator static_integrator, integrator;
+      double t_static{}, t{};
+      for (size_t i = 0; i < 100; ++i)
+      {
+         static_integrator(system, t_static, 0.01);
+         integrator(blocks, t, 0.01);
+      }
+
+      expect(system.get<1>().value == b.value) << system.get<1>().value << b.value;
+      expect(system.get<2>().value == c.value && c.value == c.limit);
+      expect(system.get<3>().value == d.value);
+      expect(system.get<3>().n_apply == d.n_apply);
+   };
+
+   "static_rk4"_test = [&] { compare.operator()<modular::RK4<double>>(); };
+   "static_pc233"_test = [&] { compare.operator()<modular::PC233<double>>(); };
+};
+
+suite phase_hooks = []
+{
+   "no_op_hooks"_test = [] {
+      static_assert(overrides_hook<ExponentialMod, Phase::Update>());
+      static_assert(!overrides_hook<ExponentialMod, Phase::Apply>());
+      static_assert(overrides_hook<CountingMod, Phase::Apply>() && overrides_hook<CountingMod, Phase::Postcalc>());
+      static_assert(!overrides_hook<CountingMod, Phase::Postprop>());
+
+      ExponentialMod a;
+      CountingMod b;
+      a.value = b.value = 1.0;
+      a.init();
+      b.init();
+      std::vector<asc::Module*> blocks{ &a, &b };
+
+      modular::RK4<double> integrator;
+      double t{};
+      integrator(blocks, t, 0.01);
+      integrator(blocks, t, 0.01);
+
+      expect(a.no_op == 0 && b.no_op == 0) << "default hooks do not mark themselves";
+      expect(b.n_apply == 8);
+      expect(a.value == b.value);
+
+      // held as Module*, the default hooks are detected from the vtable where its layout is known
+      if (detail::final_overrider(a, &asc::Module::apply))
+      {
+         expect(keeps_default<&asc::Module::apply>(a) && !keeps_default<&asc::Module::apply>(b));
+         expect(keeps_default<&asc::Module::postprop>(b) && !keeps_default<&asc::Module::operator()>(b));
+         ChainedDecayMod chained;
+         expect(!keeps_default<&asc::Module::apply>(chained));
+      }
+   };
+
+   "declared_no_op"_test = [] {
+      // hooks declared in no_op are skipped by every container
+      ModuleGraph graph;
+      auto handle = graph.emplace_back<CountingMod>();
+      graph[handle].value = 1.0;
+      graph[handle].no_op = phase_bit(Phase::Apply);
+      init(graph);
+      modular::RK4<double> integrator;
+      double t{};
+      integrator(graph, t, 0.01);
+      expect(graph[handle].n_apply == size_t{ 0 });
+      expect(approx(graph[handle].value, std::exp(t)));
+
+      // neither the discovery pass nor a Link runs an update declared in no_op
+      ChainMod source, reader;
+      reader.upstream = &source;
+      source.no_op = phase_bit(Phase::Update);
+      source.init();
+      reader.init();
+      Scheduler scheduler;
+      scheduler.emplace_back(&reader);
+      scheduler.emplace_back(&source);
+      update(scheduler);
+      expect(scheduler.discovered());
+      expect(source.n_update == size_t{ 0 } && reader.n_update == size_t{ 1 }) << source.n_update << reader.n_update;
+      expect(scheduler.n_calls(Phase::Update) == size_t{ 1 });
+   };
+
+   "chained_hooks"_test = [] {
+      // overrides that call their base's default hooks must keep running
+      auto run = [](auto& blocks, ChainedDecayMod& m) {
+         m.x = 1.0;
+         m.init();
+         modular::RK4<double> integrator;
+         double t{};
+         for (size_t i = 0; i < 100; ++i) {
+            integrator(blocks, t, 0.01);
+         }
+         expect(approx(m.x, std::exp(-1.0), 1.0e-8)) << m.x;
+         expect(m.n_apply == 400) << m.n_apply;
+      };
+
+      ChainedDecayMod a;
+      std::vector<asc::Module*> modules{ &a };
+      run(modules, a);
+
+      ChainedDecayMod b;
+      std::vector<ChainedDecayMod*> typed{ &b };
+      run(typed, b);
+
+      ChainedDecayMod c;
+      Scheduler scheduler;
+      scheduler.emplace_back(&c);
+      run(scheduler, c);
+   };
+};
+
+suite parallel_update = []
+{
+   "scheduler_levels"_test = [] {
+      // Binary tree, module i reads the output of module (i - 1) / 2
+      constexpr size_t n = 255;
+      auto make_tree = [] {
+         std::vector<std::unique_ptr<ChainMod>> tree;
+         for (size_t i = 0; i < n; ++i)
+         {
+            tree.emplace_back(std::make_unique<ChainMod>());
+            tree.back()->value = 1.0 + 0.01 * i;
+            if (i > 0) tree.back()->upstream = tree[(i - 1) / 2].get();
+            tree.back()->init();
+         }
+         return tree;
+      };
+
+      auto run = [](auto& blocks) {
+         modular::RK4<double> integrator;
+         double t{};
+         for (size_t i = 0; i < 100; ++i) {
+            integrator(blocks, t, 0.01);
+         }
+      };
+
+      // Serial reference in dependency order
+      auto reference = make_tree();
+      std::vector<asc::Module*> blocks;
+      for (auto& module : reference) blocks.emplace_back(module.get());
+      run(blocks);
+
+      // Reverse insertion order, the discovery pass sequences the calls through the Links
+      for (const unsigned n_threads : { 0u, 1u, 4u })
+      {
+         Pool pool(n_threads);
+         auto tree = make_tree();
+         Scheduler scheduler(pool);
+         scheduler.grain = 4;
+         for (auto it = tree.rbegin(); it != tree.rend(); ++it) scheduler.emplace_back(it->get());
+         run(scheduler);
+
+         expect(scheduler.n_levels() == 8);
+         expect(scheduler.level(0).size() == 1);
+         bool identical = true;
+         for (size_t i = 0; i < n; ++i) {
+            identical &= (tree[i]->value == reference[i]->value);
+         }
+         expect(identical) << n_threads << "threads";
+      }
+   };
+
+   "scheduler_discovery_once"_test = [] {
+      // the discovery pass is the first update, every module runs once and after its upstream module
+      ChainMod a, b, c;
+      b.upstream = &a;
+      c.upstream = &b;
+      Scheduler scheduler;
+      for (auto* module : { &c, &b, &a }) {
+         module->init();
+         scheduler.emplace_back(module);
+      }
+
+      update(scheduler);
+      expect(scheduler.discovered());
+      expect(a.n_update == 1 && b.n_update == 1 && c.n_update == 1) << a.n_update << b.n_update << c.n_update;
+      expect(c.output == 1.75) << c.output;
+
+      update(scheduler);
+      expect(a.n_update == 2 && b.n_update == 2 && c.n_update == 2);
+      expect(c.output == 1.75) << c.output;
+   };
+
+   "scheduler_dispatch"_test = [] {
+      CountingMod direct, indirect;
+      direct.value = indirect.value = 1.0;
+      direct.init();
+      indirect.init();
+      ExponentialMod* base = &indirect;
+
+      Scheduler scheduler;
+      scheduler.emplace_back(&direct); // hooks are called directly
+      scheduler.emplace_back(base); // dynamic type differs, hooks are called virtually
+
+      modular::RK4<double> integrator;
+      double t{};
+      for (size_t i = 0; i < 10; ++i)
+      {
+         integrator(scheduler, t, 0.01);
+         postcalc(scheduler);
+      }
+
+      expect(scheduler.discovered());
+      expect(direct.n_apply == 40 && indirect.n_apply == 40) << direct.n_apply << indirect.n_apply;
+      expect(direct.n_postcalc == 10 && indirect.n_postcalc == 10) << direct.n_postcalc << indirect.n_postcalc;
+      expect(direct.value == indirect.value);
+      expect(scheduler.n_calls(Phase::Apply) == 2);
+      // the module registered through its base type is only listed for postprop where the vtable does not show the default
+      expect(scheduler.n_calls(Phase::Postprop) == (detail::final_overrider(indirect, &asc::Module::postprop) ? 0 : 1));
+      expect(approx(direct.value, std::exp(t))) << direct.value;
+
+      scheduler.erase(base);
+      expect(!scheduler.discovered() && scheduler.size() == 1);
+   };
+
+   "parallel_propagate"_test = [] {
+      // The same model integrated serially and in parallel chunks must agree exactly
+      auto run = []<class Integrator>(Integrator& integrator, Pool* pool) {
+         ModuleGraph graph;
+         for (size_t i = 0; i < 5000; ++i) {
+            auto handle = graph.emplace_back<ExponentialMod>();
+            graph[handle].value = 1.0 + 1.0e-3 * i;
+         }
+         init(graph);
+
+         integrator.propagator.pool = pool;
+         integrator.propagator.grain = 256;
+         double t{}, dt = 0.01;
+         AdaptiveT<double> settings;
+         for (size_t i = 0; i < 20; ++i)
+         {
+            if constexpr (requires { integrator(graph, t, dt, settings); }) integrator(graph, t, dt, settings);
+            else integrator(graph, t, dt);
+         }
+
+         std::vector<double> values;
+         for (auto* module : graph) values.emplace_back(static_cast<ExponentialMod*>(module)->value);
+         return values;
+      };
+
+      Pool pool(4);
+      {
+         modular::RK4<double> serial, parallel;
+         expect(run(serial, nullptr) == run(parallel, &pool)) << "rk4";
+      }
+      {
+         modular::DOPRI45<double> serial, parallel;
+         expect(run(serial, nullptr) == run(parallel, &pool)) << "dopri45";
+      }
+      {
+         modular::VABM<double> serial, parallel;
+         expect(run(serial, nullptr) == run(parallel, &pool)) << "vabm";
+      }
+   };
+
+   "deterministic_reductions"_test = [] {
+      // Error and stiffness norms are summed over blocks of grain rows, so any pool size gives the same steps
+      auto run = []<class Integrator>(Integrator& integrator, Pool* pool) {
+         ModuleGraph graph;
+         for (size_t i = 0; i < 5000; ++i) {
+            auto handle = graph.emplace_back<ExponentialMod>();
+            graph[handle].value = 1.0 + 1.0e-3 * std::sin(0.1 * i);
+         }
+         init(graph);
+
+         integrator.propagator.pool = pool;
+         integrator.propagator.grain = 256;
+         double t{}, dt = 0.01;
+         AdaptiveT<double> settings;
+         settings.abs_tol = 1.0e-9;
+         settings.rel_tol = 1.0e-9;
+         settings.norm = Norm::RMS;
+         for (size_t i = 0; i < 20; ++i) {
+            integrator(graph, t, dt, settings);
+         }
+
+         std::vector<double> values{ t, dt };
+         for (auto* module : graph) values.emplace_back(static_cast<ExponentialMod*>(module)->value);
+         return values;
+      };
+
+      Pool one(1), three(3), four(4);
+      {
+         auto make = [] {
+            modular::DOPRI45<double> integrator;
+            integrator.stiffness_detection = true;
+            return integrator;
+         };
+         auto serial = make(), a = make(), b = make(), c = make();
+         const auto reference = run(serial, nullptr);
+         expect(run(a, &one) == reference && run(b, &three) == reference && run(c, &four) == reference) << "dopri45";
+         expect(a.stiffness() == serial.stiffness() && c.stiffness() == serial.stiffness());
+      }
+      {
+         modular::TRBDF2<double> serial, a, b;
+         const auto reference = run(serial, nullptr);
+         expect(run(a, &one) == reference && run(b, &three) == reference) << "trbdf2";
+      }
+   };
+
+   "link_trace_caller"_test = [] {
+      // a linked update that throws must not leave its module as the caller of the trace
+      ExponentialMod outer;
+      ThrowingMod failing;
+      Phase phase = Phase::Update;
+      failing.phase = &phase;
+      failing.init_run = true;
+      Link<ThrowingMod> link;
+      link = &failing;
+
+      LinkTrace trace;
+      trace.caller = &outer;
+      LinkTrace* previous = std::exchange(link_trace, &trace);
+      expect(throws<std::runtime_error>([&] { (void)link->no_op; }));
+      link_trace = previous;
+      expect(trace.caller == &outer);
+      expect(trace.edges.size() == size_t{ 1 } && trace.edges.front().first == &outer);
+   };
+
+   "link_sparsity_throws"_test = [] {
+      // the traced pass restores the previous trace if an update throws
+      ThrowingMod failing;
+      std::vector<asc::Module*> blocks{ &failing };
+      SparsityPattern pattern;
+      expect(throws<std::runtime_error>([&] { modular::link_sparsity(blocks, pattern); }));
+      expect(link_trace == nullptr);
+   };
+
+   "scheduler_circular"_test = [] {
+      ChainMod a, b;
+      a.init();
+      b.init();
+      a.upstream = &b;
+      b.upstream = &a;
+      Scheduler scheduler;
+      scheduler.emplace_back(&a);
+      scheduler.emplace_back(&b);
+      expect(throws<std::runtime_error>([&] { update(scheduler); }));
+   };
+};
+
+int main() {}